@@ -0,0 +1 @@
+git clone --depth 1 https://github.com/christopherpow/nes-test-roms.git test-roms
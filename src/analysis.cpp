@@ -0,0 +1,233 @@
+#include <algorithm>
+
+#include "analysis.hpp"
+#include "emu.hpp"
+#include "rom.hpp"
+#include "cdl.hpp"
+#include "cpu_opcodes.hpp"
+#include "cpu_mnemonics.hpp"
+
+static size_t constexpr JUMP_TABLE_MAX_ENTRIES = 128;  // Index shifted left by one
+static size_t constexpr JUMP_TABLE_LOOKBEHIND = 8;     // Instructions searched for the table loads
+
+static bool isIndexedLoad(const DisasmLine& line) {
+    switch (line.bytes[0]) {
+    case OPC_LDA_ABS_X:
+    case OPC_LDA_ABS_Y:
+    case OPC_LDX_ABS_Y:
+    case OPC_LDY_ABS_X:
+    case _OPC_LAX_ABS_Y__0:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static uint16_t getOperand(const DisasmLine& line) {
+    return line.bytes[2] << 8 | line.bytes[1];
+}
+
+StaticAnalysis::StaticAnalysis(const uint8_t* prg, size_t prgLength, const std::vector<uint8_t>& prgLog)
+    : m_prg(prg, prg + prgLength), m_prgLog(prgLog), m_usage(prgLength, UNKNOWN) {
+    m_prgLog.resize(prgLength, 0);
+    m_thread = std::thread(&StaticAnalysis::run, this);
+}
+
+StaticAnalysis::~StaticAnalysis() {
+    m_cancel = true;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+StaticAnalysis::Result StaticAnalysis::takeResult() {
+    return std::atomic_exchange(&m_result, Result());
+}
+
+void StaticAnalysis::run() {
+    size_t banks = m_prg.size() / PRG_BANK_SIZE;
+    if (banks == 0) {
+        return;
+    }
+
+    DisasmKey fixedBank = DisasmKey(banks - 1) * PRG_BANK_SIZE;
+    for (uint16_t vector : { NMI_VECTOR, RESET_VECTOR, IRQ_VECTOR }) {
+        Entry from = { fixedBank + DisasmKey(vector & (PRG_BANK_SIZE - 1)), vector };
+        enqueue(from, readWord(from.key));
+    }
+
+    // Every run of logged code and every logged indirect jump target is an entry point,
+    // at the address of the window it was logged in
+    for (size_t i = 0; i < m_prg.size(); i++) {
+        uint8_t flags = m_prgLog[i];
+        bool runStart = (flags & CodeDataLog::PRG_CODE) && (i == 0 || !(m_prgLog[i - 1] & CodeDataLog::PRG_CODE));
+        if (runStart || (flags & CodeDataLog::PRG_INDIRECT_CODE)) {
+            uint16_t address = 0x8000 | ((flags & CodeDataLog::PRG_WINDOW) << 11) | (i & 0x1fff);
+            m_queue.push_back({ DisasmKey(i), address });
+        }
+    }
+
+    while (!m_queue.empty() && !m_cancel) {
+        Entry entry = m_queue.front();
+        m_queue.pop_front();
+        disasmPath(entry);
+    }
+
+    if (m_cancel) {
+        return;
+    }
+
+    std::sort(m_lines.begin(), m_lines.end(),
+        [](const DisasmLine& a, const DisasmLine& b) { return a.key < b.key; });
+    std::atomic_store(&m_result, Result(std::make_shared<const std::vector<DisasmLine>>(std::move(m_lines))));
+}
+
+// Decodes linearly from entry until flow cannot continue or already decoded bytes are reached
+void StaticAnalysis::disasmPath(Entry entry) {
+    std::vector<DisasmLine> path;
+
+    while (!m_cancel && entry.key < m_prg.size() && m_usage[entry.key] == UNKNOWN) {
+        uint8_t flags = m_prgLog[entry.key];
+        if ((flags & (CodeDataLog::PRG_CODE | CodeDataLog::PRG_DATA)) == CodeDataLog::PRG_DATA) {
+            break;
+        }
+
+        DisasmLine line;
+        line.key = entry.key;
+        line.offset = entry.address;
+        line.bytes[0] = m_prg[entry.key];
+        Opcode::AddressingMode mode = Opcode::addressingModes[line.bytes[0]];
+        if (mode == Opcode::Undefined) {
+            break;
+        }
+        line.size = Opcode::paramCount[mode] + 1;
+
+        // Lines must not reach past the PRG, into the next bank or window, or into decoded bytes.
+        // Entries from the CDL can sit in a window that does not match their bank offset.
+        if (entry.key + line.size > m_prg.size()
+            || (entry.key & (PRG_BANK_SIZE - 1)) + line.size > PRG_BANK_SIZE
+            || (entry.address & (PRG_BANK_SIZE - 1)) + line.size > PRG_BANK_SIZE) {
+            break;
+        }
+        bool overlaps = false;
+        for (uint8_t i = 1; i < 3; i++) {
+            line.bytes[i] = i < line.size ? m_prg[entry.key + i] : 0;
+            overlaps |= i < line.size && m_usage[entry.key + i] != UNKNOWN;
+        }
+        if (overlaps) {
+            break;
+        }
+
+        m_usage[entry.key] = OPCODE;
+        for (uint8_t i = 1; i < line.size; i++) {
+            m_usage[entry.key + i] = OPERAND;
+        }
+        m_lines.push_back(line);
+        path.push_back(line);
+
+        uint8_t opc = line.bytes[0];
+        if (mode == Opcode::Relative) {
+            enqueue(entry, entry.address + line.size + int8_t(line.bytes[1]));
+        } else if (opc == OPC_JSR) {
+            enqueue(entry, getOperand(line));
+        } else if (opc == OPC_JMP) {
+            enqueue(entry, getOperand(line));
+            break;
+        } else if (opc == OPC_JMP_IND || opc == OPC_RTS) {
+            resolveJumpTable(entry, path, opc == OPC_RTS);
+            break;
+        } else if (opc == OPC_RTI || opc == OPC_BRK) {
+            break;
+        }
+
+        if (uint32_t(entry.address) + line.size > 0xffff) {
+            break;
+        }
+        entry.key += line.size;
+        entry.address += line.size;
+    }
+}
+
+// Recognizes the common dispatch idioms, with the index already shifted left:
+//   LDA table,X / STA ptr / LDA table+1,X / STA ptr+1 / JMP (ptr)
+//   LDA table+1,X / PHA / LDA table,X / PHA / RTS     (entries hold target - 1)
+// The table is read until an entry does not point to a valid opcode in ROM.
+void StaticAnalysis::resolveJumpTable(const Entry& from, const std::vector<DisasmLine>& path, bool viaRts) {
+    size_t first = path.size() > JUMP_TABLE_LOOKBEHIND ? path.size() - JUMP_TABLE_LOOKBEHIND : 0;
+    int pushes = 0;
+    bool found = false;
+    uint16_t table = 0;
+    for (size_t i = first; i < path.size(); i++) {
+        if (path[i].bytes[0] == OPC_PHA) {
+            pushes++;
+        }
+        for (size_t j = first; j < path.size() && isIndexedLoad(path[i]); j++) {
+            if (isIndexedLoad(path[j]) && getOperand(path[j]) == getOperand(path[i]) + 1) {
+                table = getOperand(path[i]);
+                found = true;
+            }
+        }
+    }
+    if (!found || (viaRts && pushes < 2)) {
+        return;
+    }
+
+    DisasmKey tableKey = resolve(from, table);
+    if (tableKey == INVALID_KEY) {
+        return;
+    }
+
+    for (size_t i = 0; i < JUMP_TABLE_MAX_ENTRIES; i++) {
+        DisasmKey key = tableKey + DisasmKey(2 * i);
+        uint16_t address = uint16_t(table + 2 * i);
+        if ((address & (PRG_BANK_SIZE - 1)) + 2 > PRG_BANK_SIZE || key + 1 >= m_prg.size()) {
+            break;
+        }
+        if (m_usage[key] != UNKNOWN || m_usage[key + 1] != UNKNOWN || (m_prgLog[key] & CodeDataLog::PRG_CODE)) {
+            // Ran into code or another table
+            break;
+        }
+
+        uint16_t target = readWord(key) + (viaRts ? 1 : 0);
+        DisasmKey targetKey = resolve(from, target);
+        if (targetKey == INVALID_KEY
+            || Opcode::addressingModes[m_prg[targetKey]] == Opcode::Undefined
+            || (m_usage[targetKey] != UNKNOWN && m_usage[targetKey] != OPCODE)) {
+            break;
+        }
+
+        m_usage[key] = TABLE;
+        m_usage[key + 1] = TABLE;
+        enqueue(from, target);
+    }
+}
+
+void StaticAnalysis::enqueue(const Entry& from, uint16_t target) {
+    DisasmKey key = resolve(from, target);
+    if (key != INVALID_KEY && m_usage[key] == UNKNOWN) {
+        m_queue.push_back({ key, target });
+    }
+}
+
+DisasmKey StaticAnalysis::resolve(const Entry& from, uint16_t target) const {
+    if (target < 0x8000) {
+        return INVALID_KEY;
+    }
+
+    size_t banks = m_prg.size() / PRG_BANK_SIZE;
+    uint16_t offset = target & (PRG_BANK_SIZE - 1);
+    DisasmKey key;
+    if ((target & ~(PRG_BANK_SIZE - 1)) == (from.address & ~(PRG_BANK_SIZE - 1))) {
+        // Same window, same bank
+        key = from.key - (from.address & (PRG_BANK_SIZE - 1)) + offset;
+    } else if (target >= 0xc000) {
+        key = DisasmKey(banks - 1) * PRG_BANK_SIZE + offset;
+    } else if (banks <= 2) {
+        key = offset;
+    } else {
+        // Unknown which bank is switched in
+        return INVALID_KEY;
+    }
+
+    return key < m_prg.size() ? key : INVALID_KEY;
+}
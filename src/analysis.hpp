@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <atomic>
+
+#include "disasm.hpp"
+
+// Recursive descent disassembly of the whole PRG ROM, run on a worker thread.
+// Starts at the interrupt vectors and at code recorded by the Code/Data Logger.
+// Works on copies of PRG ROM and the log, so the emulation is never touched.
+//
+// Banks are assumed to be 16 KB with the last bank fixed at $C000, the layout
+// of NROM, UxROM and MMC1 in its default mode. Targets in the switchable window
+// can only be resolved from within the same bank, other banks are reached
+// through logged code.
+class StaticAnalysis {
+public:
+    using Result = std::shared_ptr<const std::vector<DisasmLine>>;
+
+    StaticAnalysis(const uint8_t* prg, size_t prgLength, const std::vector<uint8_t>& prgLog);
+    ~StaticAnalysis();
+
+    // Lines sorted by key, nullptr until the analysis has finished
+    Result takeResult();
+
+private:
+    static DisasmKey constexpr INVALID_KEY = ~DisasmKey(0);
+
+    enum Usage : uint8_t {
+        UNKNOWN = 0,
+        OPCODE,
+        OPERAND,
+        TABLE,     // Entry of a jump table
+    };
+
+    struct Entry {
+        DisasmKey key;
+        uint16_t address;
+    };
+
+    std::vector<uint8_t> m_prg;
+    std::vector<uint8_t> m_prgLog;
+    std::vector<uint8_t> m_usage;
+    std::vector<DisasmLine> m_lines;
+    std::deque<Entry> m_queue;
+
+    Result m_result;  // Only accessed through the std::atomic_* functions for shared_ptr
+    std::atomic<bool> m_cancel{ false };
+    std::thread m_thread;
+
+    void run();
+    void disasmPath(Entry entry);
+    void resolveJumpTable(const Entry& from, const std::vector<DisasmLine>& path, bool viaRts);
+
+    void enqueue(const Entry& from, uint16_t target);
+    DisasmKey resolve(const Entry& from, uint16_t target) const;
+    uint16_t readWord(DisasmKey key) const { return m_prg[key] | (m_prg[key + 1] << 8); }
+};
@@ -0,0 +1,150 @@
+#include <algorithm>
+
+#include "batch.hpp"
+#include "emu.hpp"
+#include "mem.hpp"
+#include "ppu.hpp"
+#include "rom.hpp"
+#include "core/util.hpp"
+#include "core/tracer.hpp"
+
+BatchEmu::BatchEmu(const std::filesystem::path& rom, size_t count,
+                   unsigned int frameSkip, unsigned int downscale, unsigned int threads)
+    : m_frameSkip(std::max(1u, frameSkip)), m_downscale(std::max(1u, downscale)) {
+    m_ram.resize(count * Memory::INTERNAL_RAM_SIZE);
+    m_frames.resize(count * PPU::SCREEN_WIDTH * PPU::SCREEN_HEIGHT);
+    if (m_downscale > 1) {
+        m_observations.resize(count * observationWidth() * observationHeight());
+    }
+    m_errors.resize(count);
+
+    // The carts share one ROM image, battery RAM is not mapped so instances don't overwrite each other's
+    for (size_t i = 0; i < count; i++) {
+        std::shared_ptr<Cart> cart = Cart::fromFile(rom, false);
+        if (!cart) {
+            m_emus.clear();
+            return;
+        }
+
+        std::unique_ptr<Emu> emu = std::make_unique<Emu>(Emu::Config{});
+        emu->setOutputBuffers(&m_ram[i * Memory::INTERNAL_RAM_SIZE], &m_frames[i * PPU::SCREEN_WIDTH * PPU::SCREEN_HEIGHT]);
+        emu->init(cart);
+        emu->m_isStepping = false;
+        m_emus.push_back(std::move(emu));
+    }
+
+    // The calling thread works as well
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = unsigned(std::min<size_t>(threads, count));
+    for (unsigned int i = 1; i < threads; i++) {
+        m_threads.emplace_back(&BatchEmu::work, this);
+    }
+}
+
+BatchEmu::~BatchEmu() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_started.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+unsigned int BatchEmu::observationWidth() const {
+    return (PPU::SCREEN_WIDTH + m_downscale - 1) / m_downscale;
+}
+
+unsigned int BatchEmu::observationHeight() const {
+    return (PPU::SCREEN_HEIGHT + m_downscale - 1) / m_downscale;
+}
+
+void BatchEmu::step(const uint8_t* inputs) {
+    if (m_emus.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // m_next last, a worker still leaving the previous step may take an instance as soon as it is reset
+        m_inputs = inputs;
+        m_pending = m_emus.size();
+        m_next = 0;
+        m_generation++;
+    }
+    m_started.notify_all();
+
+    runInstances();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_finished.wait(lock, [this]() { return m_pending == 0; });
+}
+
+void BatchEmu::reset(size_t index) {
+    m_emus[index]->powerOn();
+    m_emus[index]->m_isStepping = false;
+    m_errors[index] = 0;
+}
+
+void BatchEmu::resetAll() {
+    for (size_t i = 0; i < m_emus.size(); i++) {
+        reset(i);
+    }
+}
+
+void BatchEmu::work() {
+    Tracer::setThreadName("Batch Worker");
+
+    uint64_t generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_started.wait(lock, [&]() { return m_quit || m_generation != generation; });
+            if (m_quit) {
+                return;
+            }
+            generation = m_generation;
+        }
+        runInstances();
+    }
+}
+
+void BatchEmu::runInstances() {
+    for (size_t i = m_next++; i < m_emus.size(); i = m_next++) {
+        stepInstance(i);
+
+        if (--m_pending == 0) {
+            // Locked so the caller can't miss the notification between its check and its wait
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_finished.notify_one();
+        }
+    }
+}
+
+void BatchEmu::stepInstance(size_t index) {
+    Tracer::Span span("Step Instance", "batch");
+    Emu& emu = *m_emus[index];
+    if (!m_errors[index]) {
+        emu.setFrameInputs(Input::Controller::fromBits(m_inputs[2 * index]),
+                           Input::Controller::fromBits(m_inputs[2 * index + 1]));
+        for (unsigned int i = 0; i < m_frameSkip && !emu.m_isStepping; i++) {
+            // Only the last frame is observed
+            emu.setRenderSkip(!m_render || i + 1 < m_frameSkip);
+            emu.stepFrame();
+        }
+        m_errors[index] = emu.m_isStepping;
+    }
+
+    if (m_render && m_downscale > 1) {
+        const uint8_t* frame = &m_frames[index * PPU::SCREEN_WIDTH * PPU::SCREEN_HEIGHT];
+        uint8_t* observation = &m_observations[index * observationWidth() * observationHeight()];
+        for (unsigned int y = 0; y < PPU::SCREEN_HEIGHT; y += m_downscale) {
+            for (unsigned int x = 0; x < PPU::SCREEN_WIDTH; x += m_downscale) {
+                *observation++ = frame[y * PPU::SCREEN_WIDTH + x];
+            }
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <filesystem>
+
+class Emu;
+
+// Many independent emulators of the same ROM, stepped in lockstep on a pool
+// of worker threads, e.g. to train agents. RAM and frames of all instances
+// are kept in contiguous arrays, instance by instance, so they can be handed
+// on without copying.
+class BatchEmu {
+public:
+    // Each step runs frameSkip frames with the same inputs. Observations keep
+    // every downscale-th pixel of every downscale-th row.
+    BatchEmu(const std::filesystem::path& rom, size_t count,
+             unsigned int frameSkip = 1, unsigned int downscale = 1, unsigned int threads = 0);
+    ~BatchEmu();
+
+    bool isValid() const { return !m_emus.empty(); }
+    size_t size() const { return m_emus.size(); }
+
+    // inputs holds two controller bitmasks per instance, see Input::Controller::toBits
+    void step(const uint8_t* inputs);
+
+    // Without rendering only RAM is updated, which is a lot faster
+    void setRendering(bool render) { m_render = render; }
+
+    // Back to power on, for one or all instances
+    void reset(size_t index);
+    void resetAll();
+
+    // size() * Memory::INTERNAL_RAM_SIZE bytes
+    const uint8_t* ram() const { return m_ram.data(); }
+    // size() * PPU::SCREEN_WIDTH * PPU::SCREEN_HEIGHT palette values
+    const uint8_t* frames() const { return m_frames.data(); }
+    // size() * observationWidth() * observationHeight() palette values, the frames if not downscaled
+    const uint8_t* observations() const { return m_downscale > 1 ? m_observations.data() : m_frames.data(); }
+    unsigned int observationWidth() const;
+    unsigned int observationHeight() const;
+    // Non-zero for instances that stopped on a CPU error during the last step, they need a reset
+    const uint8_t* errors() const { return m_errors.data(); }
+
+private:
+    unsigned int m_frameSkip;
+    unsigned int m_downscale;
+    bool m_render = true;
+
+    std::vector<std::unique_ptr<Emu>> m_emus;
+    std::vector<uint8_t> m_ram;
+    std::vector<uint8_t> m_frames;
+    std::vector<uint8_t> m_observations;
+    std::vector<uint8_t> m_errors;
+
+    // A step hands out instances through m_next, the last one to finish wakes the caller
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_started;
+    std::condition_variable m_finished;
+    uint64_t m_generation = 0;
+    bool m_quit = false;
+    const uint8_t* m_inputs = nullptr;
+    std::atomic<size_t> m_next{ 0 };
+    std::atomic<size_t> m_pending{ 0 };
+
+    void work();
+    void runInstances();
+    void stepInstance(size_t index);
+};
@@ -0,0 +1,80 @@
+#include <fstream>
+
+#include "cdl.hpp"
+#include "rom.hpp"
+#include "core/util.hpp"
+
+void CodeDataLog::reset(std::shared_ptr<Cart> cart) {
+    m_cart = cart;
+    m_prg.assign(PRG_BANK_SIZE * m_cart->prgSize(), 0);
+    if (m_cart->m_useChrRam) {
+        // Nothing static to log for CHR RAM
+        m_chr.clear();
+    } else {
+        m_chr.assign(CHR_BANK_SIZE * m_cart->chrSize(), 0);
+    }
+}
+
+bool CodeDataLog::load(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ifstream::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+
+    size_t len;
+    uint8_t* data = readFile(in, &len);
+    in.close();
+
+    if (len != m_prg.size() + m_chr.size()) {
+        LOG_ERR << "Code/Data Log " << path << " does not match ROM size\n";
+        delete[] data;
+        return false;
+    }
+
+    std::copy(data, data + m_prg.size(), m_prg.begin());
+    std::copy(data + m_prg.size(), data + len, m_chr.begin());
+    delete[] data;
+
+    LOG_MSG << "Loaded Code/Data Log " << path << "\n";
+    return true;
+}
+
+bool CodeDataLog::save(const std::filesystem::path& path) const {
+    if (m_prg.empty()) {
+        return false;
+    }
+
+    std::ofstream out(path, std::ofstream::binary);
+    if (!out.is_open()) {
+        LOG_ERR << "Code/Data Log " << path << " could not be opened.\n";
+        return false;
+    }
+
+    out.write((const char*)m_prg.data(), m_prg.size());
+    out.write((const char*)m_chr.data(), m_chr.size());
+    out.close();
+    return true;
+}
+
+uint8_t CodeDataLog::getPrg(uint16_t address) const {
+    if (address < 0x8000 || m_prg.empty()) {
+        return 0;
+    }
+
+    size_t index = m_cart->prgOffset(address);
+    return index < m_prg.size() ? m_prg[index] : 0;
+}
+
+void CodeDataLog::markPrg(uint16_t address, uint8_t flags) {
+    size_t index = m_cart->prgOffset(address);
+    if (index < m_prg.size()) {
+        m_prg[index] |= flags | ((address >> 11) & PRG_WINDOW);
+    }
+}
+
+void CodeDataLog::markChr(uint16_t address, uint8_t flags) {
+    size_t index = m_cart->chrOffset(address);
+    if (index < m_chr.size()) {
+        m_chr[index] |= flags;
+    }
+}
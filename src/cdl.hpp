@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <filesystem>
+
+class Cart;
+
+// Code/Data Logger, records how each byte of the cartridge is used.
+// The layout matches the .cdl files written by FCEUX: one flag byte per
+// PRG ROM byte, followed by one flag byte per CHR ROM byte.
+// See http://fceux.com/web/help/CodeDataLogger.html
+class CodeDataLog {
+public:
+    // PRG flags
+    static uint8_t constexpr PRG_CODE          = 0x01;  // Executed as opcode or operand
+    static uint8_t constexpr PRG_DATA          = 0x02;  // Read as data
+    static uint8_t constexpr PRG_WINDOW        = 0x0c;  // 8 KB CPU window the byte was mapped to when logged
+    static uint8_t constexpr PRG_INDIRECT_CODE = 0x10;  // Target of an indirect jump
+    static uint8_t constexpr PRG_INDIRECT_DATA = 0x20;  // Read via (zp,X) or (zp),Y
+
+    // CHR flags
+    static uint8_t constexpr CHR_RENDERED      = 0x01;  // Fetched by the PPU for rendering
+    static uint8_t constexpr CHR_READ          = 0x02;  // Read by the CPU through PPUDATA
+
+    bool m_enabled = true;
+
+    void reset(std::shared_ptr<Cart> cart);
+    void setCart(std::shared_ptr<Cart> cart) { m_cart = cart; }  // Keeps the log, for another cart of the same ROM
+
+    bool load(const std::filesystem::path& path);
+    bool save(const std::filesystem::path& path) const;
+
+    inline void logPrg(uint16_t address, uint8_t flags) {
+        if (m_enabled && address >= 0x8000) {
+            markPrg(address, flags);
+        }
+    }
+
+    inline void logChr(uint16_t address, uint8_t flags) {
+        if (m_enabled && !m_chr.empty()) {
+            markChr(address, flags);
+        }
+    }
+
+    uint8_t getPrg(uint16_t address) const;
+
+    bool isCode(uint16_t address) const { return getPrg(address) & PRG_CODE; }
+    bool isData(uint16_t address) const { return (getPrg(address) & (PRG_CODE | PRG_DATA)) == PRG_DATA; }
+
+    size_t prgSize() const { return m_prg.size(); }
+    const std::vector<uint8_t>& prgLog() const { return m_prg; }
+    size_t chrSize() const { return m_chr.size(); }
+
+private:
+    std::shared_ptr<Cart> m_cart;
+
+    std::vector<uint8_t> m_prg;
+    std::vector<uint8_t> m_chr;
+
+    void markPrg(uint16_t address, uint8_t flags);
+    void markChr(uint16_t address, uint8_t flags);
+};
@@ -0,0 +1,73 @@
+#include "control.hpp"
+#include "emu.hpp"
+#include "core/util.hpp"
+
+ControlServer::ControlServer(Emu& emu) : m_emu(emu) {}
+
+ControlServer::~ControlServer() {
+    // Before the region is unmapped with m_memory
+    m_emu.setOutputBuffers(nullptr, nullptr);
+}
+
+bool ControlServer::open(const std::string& name) {
+    std::string prefix = "/sta-" + name;
+    if (!m_memory.create(prefix, sizeof(ControlRegion))
+        || !m_request.create(prefix + "-request")
+        || !m_done.create(prefix + "-done")) {
+        return false;
+    }
+
+    m_region = (ControlRegion*)m_memory.data();
+    m_region->version = ControlRegion::REGION_VERSION;
+    m_emu.setOutputBuffers(m_region->ram, m_region->frame);
+
+    LOG_MSG << "Waiting for control requests on " << prefix << "\n";
+    return true;
+}
+
+void ControlServer::serve() {
+    m_region->magic = ControlRegion::MAGIC;
+
+    while (m_request.wait()) {
+        uint32_t status = ControlRegion::Ok;
+        switch (m_region->command) {
+        case ControlRegion::Step:
+            status = step(m_region->frames);
+            break;
+        case ControlRegion::Reset:
+            m_emu.reset();
+            break;
+        case ControlRegion::PowerOn:
+            m_emu.powerOn();
+            m_frameCount = 0;
+            break;
+        case ControlRegion::Quit:
+            m_region->magic = 0;
+            m_done.post();
+            return;
+        default:
+            status = ControlRegion::UnknownCommand;
+            break;
+        }
+
+        m_region->status = status;
+        m_region->frameCount = m_frameCount;
+        m_done.post();
+    }
+}
+
+uint32_t ControlServer::step(uint32_t frames) {
+    m_emu.setFrameInputs(Input::Controller::fromBits(m_region->inputs[0]), Input::Controller::fromBits(m_region->inputs[1]));
+    m_emu.m_isStepping = false;
+
+    for (uint32_t i = 0; i < frames; i++) {
+        // Only the last frame is observed
+        m_emu.setRenderSkip(i + 1 < frames);
+        m_emu.stepFrame();
+        m_frameCount++;
+        if (m_emu.m_isStepping) {
+            return ControlRegion::CpuError;
+        }
+    }
+    return ControlRegion::Ok;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+#include "core/sharedmemory.hpp"
+
+class Emu;
+
+// Lets another process drive the emulator, for bots and agents. Everything is
+// exchanged through one shared memory region named "/sta-<name>" (on Windows
+// "Local\sta-<name>"), RAM and frame are written there by the emulator itself.
+//
+// A step: the client fills in command, frames and inputs, posts the semaphore
+// "/sta-<name>-request" and waits on "/sta-<name>-done". Once that returns,
+// status, frameCount, ram and frame describe the state after the last frame.
+struct ControlRegion {
+    static uint32_t constexpr MAGIC = 0x4154532e;  // ".STA"
+    static uint32_t constexpr REGION_VERSION = 1;
+
+    enum Command : uint32_t {
+        Step = 0,     // Runs frames frames with inputs held
+        Reset = 1,
+        PowerOn = 2,
+        Quit = 3,
+    };
+
+    enum Status : uint32_t {
+        Ok = 0,
+        UnknownCommand = 1,
+        CpuError = 2,  // Stopped on an unhandled opcode, frameCount tells where
+    };
+
+    uint32_t magic;        // MAGIC once the emulator waits for requests
+    uint32_t version;
+
+    // Written by the client
+    uint32_t command;
+    uint32_t frames;
+    uint8_t inputs[2];     // Controller 1 and 2, A in bit 0 like Input::Controller::toBits
+    uint8_t reserved[2];
+
+    // Written by the emulator
+    uint32_t status;
+    uint64_t frameCount;   // Frames since power on
+    uint8_t ram[0x800];
+    uint8_t frame[256 * 240];  // Palette values, row by row
+};
+static_assert(offsetof(ControlRegion, frameCount) == 24, "ControlRegion layout is shared with clients");
+static_assert(offsetof(ControlRegion, frame) == 32 + 0x800, "ControlRegion layout is shared with clients");
+
+class ControlServer {
+public:
+    ControlServer(Emu& emu);
+    ~ControlServer();
+
+    // Must be called before the cart is loaded, the emulator writes into the region from power on
+    bool open(const std::string& name);
+
+    // Handles requests until the client sends Quit
+    void serve();
+
+private:
+    Emu& m_emu;
+
+    Util::SharedMemory m_memory;
+    Util::NamedSemaphore m_request;
+    Util::NamedSemaphore m_done;
+    ControlRegion* m_region = nullptr;
+
+    uint64_t m_frameCount = 0;
+
+    uint32_t step(uint32_t frames);
+};
@@ -12,6 +12,7 @@
 #include "core/gui/opengl.hpp"
 #include "core/gui/notifications.hpp"
 #include "core/recents.hpp"
+#include "core/profiler.hpp"
 #include "core/util.hpp"
 #include "inputs.hpp"
 #include "IconsMaterialDesign.h"
@@ -222,7 +223,7 @@ namespace Gui {
             menubar[menu][label] = item;
         }
 
-        void checkbox(const std::string& menu, const std::string& label, Action item) {
+        void checkbox(const std::string& menu, const std::string& label, Checkbox item) {
             menubar[menu][label] = item;
         }
 
@@ -328,7 +329,12 @@ namespace Gui {
             glClearColor(CLEAR_COLOR.x, CLEAR_COLOR.y, CLEAR_COLOR.z, CLEAR_COLOR.w);
             glClear(GL_COLOR_BUFFER_BIT);
 
-            screenSurface->upload();
+            {
+                Profiler::ScopedTimer timer(Profiler::Stage::Upload);
+                screenSurface->upload();
+            }
+
+            Profiler::ScopedTimer timer(Profiler::Stage::Render);
             screenSurface->render(display_w, display_h);
         }
 
@@ -429,12 +435,23 @@ namespace Gui {
             }
         }
 
+        // Starts loading in the background, the result is reported as a notification
         bool openFile(EmuType& emu, const std::filesystem::path& path) {
-            bool ret = emu.init(path);
-            if (ret) {
-                Util::addRecent(recentFiles, path);
+            std::string name = path.filename().string();
+            bool started = emu.loadAsync(path, [this, path, name](bool loaded) {
+                if (loaded) {
+                    Util::addRecent(recentFiles, path);
+                    Gui::addNotification("Loaded " + name);
+                } else {
+                    Gui::addNotification("Could not load " + name);
+                }
+            });
+            if (started) {
+                Gui::addNotification("Loading " + name + "...");
+            } else {
+                Gui::addNotification("Still loading another ROM");
             }
-            return ret;
+            return started;
         }
 
         void renderOpenRomDialog(EmuType& emu) {
@@ -460,6 +477,8 @@ namespace Gui {
             // - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application.
             // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
 
+            Profiler::ScopedTimer uiTimer(Profiler::Stage::Ui);
+
             // Start the Dear ImGui frame
             ImGui_Impl_NewFrame();
             ImGui::NewFrame();
@@ -485,7 +504,11 @@ namespace Gui {
 
             // Rendering
             ImGui::Render();
+            uiTimer.stop();
+
             renderFrame();
+
+            Profiler::ScopedTimer uiRenderTimer(Profiler::Stage::UiRender);
             ImGui_Impl_RenderDrawData(ImGui::GetDrawData());
         }
 
@@ -495,7 +518,10 @@ namespace Gui {
                 emu.m_isStepping = true;
             }
             else {
-                emu.stepFrame();
+                {
+                    Profiler::ScopedTimer timer(Profiler::Stage::Emulation);
+                    emu.stepFrame();
+                }
                 renderFrame();
             }
         }
@@ -509,6 +535,7 @@ namespace Gui {
         }
 
         void swapBuffers() {
+            Profiler::ScopedTimer timer(Profiler::Stage::Swap);
             Gui::swapBuffers(handle);
         }
     };
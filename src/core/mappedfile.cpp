@@ -0,0 +1,147 @@
+#include "mappedfile.hpp"
+#include "util.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace Util;
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::openReadOnly(const std::filesystem::path& path) {
+    return open(path, 0, false);
+}
+
+bool MappedFile::openReadWrite(const std::filesystem::path& path, size_t length) {
+    return open(path, length, true);
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::filesystem::path& path, size_t length, bool writable) {
+    close();
+
+    m_file = CreateFileW(path.c_str(),
+                         writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                         // The cart that is swapped out still holds its mapping while the next one opens the file
+                         FILE_SHARE_READ | FILE_SHARE_WRITE,
+                         nullptr,
+                         writable ? OPEN_ALWAYS : OPEN_EXISTING,
+                         FILE_ATTRIBUTE_NORMAL,
+                         nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) {
+        m_file = nullptr;
+        LOG_ERR << "Could not open " << path << "\n";
+        return false;
+    }
+
+    if (!writable) {
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(m_file, &fileSize);
+        length = size_t(fileSize.QuadPart);
+    }
+    if (length == 0) {
+        LOG_ERR << "Could not map empty file " << path << "\n";
+        close();
+        return false;
+    }
+
+    // A writable mapping larger than the file extends it with zeros
+    m_mapping = CreateFileMappingW(m_file, nullptr,
+                                   writable ? PAGE_READWRITE : PAGE_READONLY,
+                                   DWORD(uint64_t(length) >> 32), DWORD(length & 0xffffffff),
+                                   nullptr);
+    if (m_mapping != nullptr) {
+        m_data = (uint8_t*)MapViewOfFile(m_mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, length);
+    }
+    if (m_data == nullptr) {
+        LOG_ERR << "Could not map " << path << "\n";
+        close();
+        return false;
+    }
+
+    m_size = length;
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+    }
+    if (m_file) {
+        CloseHandle(m_file);
+    }
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_file = nullptr;
+    m_size = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::filesystem::path& path, size_t length, bool writable) {
+    close();
+
+    m_fd = ::open(path.c_str(), writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (m_fd < 0) {
+        LOG_ERR << "Could not open " << path << "\n";
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(m_fd, &st) != 0) {
+        LOG_ERR << "Could not stat " << path << "\n";
+        close();
+        return false;
+    }
+    if (!writable) {
+        length = size_t(st.st_size);
+    } else if (size_t(st.st_size) < length && ftruncate(m_fd, off_t(length)) != 0) {
+        LOG_ERR << "Could not extend " << path << "\n";
+        close();
+        return false;
+    }
+    if (length == 0) {
+        LOG_ERR << "Could not map empty file " << path << "\n";
+        close();
+        return false;
+    }
+
+    void* data = mmap(nullptr, length, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED) {
+        LOG_ERR << "Could not map " << path << "\n";
+        close();
+        return false;
+    }
+
+    m_data = (uint8_t*)data;
+    m_size = length;
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) {
+        munmap(m_data, m_size);
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+    m_data = nullptr;
+    m_fd = -1;
+    m_size = 0;
+}
+
+#endif
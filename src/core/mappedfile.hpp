@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+
+namespace Util {
+    // File mapped into memory. Writes to a writable mapping go to the file
+    // through the OS page cache, so they persist even if the process dies.
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // Maps the whole file read-only
+        bool openReadOnly(const std::filesystem::path& path);
+        // Maps the first length bytes, the file is created or zero-extended as needed
+        bool openReadWrite(const std::filesystem::path& path, size_t length);
+        void close();
+
+        bool isOpen() const { return m_data != nullptr; }
+        uint8_t* data() const { return m_data; }
+        size_t size() const { return m_size; }
+
+    private:
+        uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+
+#ifdef _WIN32
+        void* m_file = nullptr;
+        void* m_mapping = nullptr;
+#else
+        int m_fd = -1;
+#endif
+
+        bool open(const std::filesystem::path& path, size_t length, bool writable);
+    };
+}
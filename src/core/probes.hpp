@@ -0,0 +1,29 @@
+#pragma once
+
+// Static tracepoints for perf and bpftrace on Linux, in the style of sys/sdt.h.
+// An unattached probe is a single nop, elsewhere or with STA_NO_PROBES they
+// compile to nothing and their arguments are not evaluated.
+//
+//   bpftrace -l 'usdt:./sta:sta:*'
+//   bpftrace -e 'usdt:./sta:sta:frame__start { @s = nsecs } usdt:./sta:sta:frame__end /@s/ { @us = hist((nsecs - @s) / 1000) }'
+//
+// Probes and their arguments:
+//   frame__start, frame__end    (cpu cycle)
+//   nmi, irq                    (pc, cpu cycle)
+//   dma__start                  (page, cpu cycle)
+//   dma__end                    (cpu cycle)
+//   prg__bank, chr__bank        (page, bank), only when the mapping changes
+//   rom__load__start            (path)
+//   rom__load__end              (path, loaded)
+
+#if defined(__linux__) && !defined(STA_NO_PROBES) && __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+
+#define STA_PROBE0(name)          DTRACE_PROBE(sta, name)
+#define STA_PROBE1(name, a)       DTRACE_PROBE1(sta, name, a)
+#define STA_PROBE2(name, a, b)    DTRACE_PROBE2(sta, name, a, b)
+#else
+#define STA_PROBE0(name)          do {} while (0)
+#define STA_PROBE1(name, a)       do {} while (0)
+#define STA_PROBE2(name, a, b)    do {} while (0)
+#endif
@@ -0,0 +1,94 @@
+#include <algorithm>
+
+#include "core/profiler.hpp"
+
+namespace Profiler {
+    const char* const STAGE_NAMES[STAGE_COUNT] = {
+        "Frame", "Emulation", "PPU", "Upload", "Render", "UI", "UI Render", "Swap",
+    };
+
+    namespace detail {
+        std::atomic<bool> enabled = false;
+    }
+
+    // Nanoseconds of the running frame
+    static std::array<std::atomic<int64_t>, STAGE_COUNT> running = {};
+    static Clock::time_point frameStart;
+
+    static std::array<Frame, HISTORY> ring;
+    static std::atomic<uint64_t> written = 0;
+    static std::atomic<uint64_t> first = 0;  // Frames before were recorded in an earlier session
+
+    void setEnabled(bool enabled) {
+        if (enabled && !isEnabled()) {
+            for (auto& stage : running) {
+                stage.store(0, std::memory_order_relaxed);
+            }
+            frameStart = Clock::now();
+            first.store(written.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        detail::enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    void beginFrame() {
+        if (!isEnabled()) {
+            return;
+        }
+
+        Clock::time_point now = Clock::now();
+        add(Stage::Frame, now - frameStart);
+        frameStart = now;
+
+        uint64_t index = written.load(std::memory_order_relaxed);
+        Frame& frame = ring[index % HISTORY];
+        for (size_t i = 0; i < STAGE_COUNT; i++) {
+            frame.ms[i] = float(running[i].exchange(0, std::memory_order_relaxed)) / 1e6f;
+        }
+        written.store(index + 1, std::memory_order_release);
+    }
+
+    void add(Stage stage, Clock::duration duration) {
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        running[size_t(stage)].fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    void getHistory(std::vector<Frame>& frames) {
+        uint64_t end = written.load(std::memory_order_acquire);
+        uint64_t begin = std::max(first.load(std::memory_order_relaxed), end > HISTORY ? end - HISTORY : 0);
+
+        frames.clear();
+        for (uint64_t i = begin; i < end; i++) {
+            frames.push_back(ring[i % HISTORY]);
+        }
+    }
+
+    Summary summarize(std::vector<float> values) {
+        Summary summary;
+        if (values.empty()) {
+            return summary;
+        }
+
+        std::sort(values.begin(), values.end());
+        double sum = 0;
+        for (float value : values) {
+            sum += value;
+        }
+
+        auto percentile = [&](double p) { return values[size_t(p * (values.size() - 1) + 0.5)]; };
+        summary.average = float(sum / values.size());
+        summary.p50 = percentile(0.50);
+        summary.p95 = percentile(0.95);
+        summary.p99 = percentile(0.99);
+        summary.max = values.back();
+        return summary;
+    }
+
+    Summary summarize(const std::vector<Frame>& frames, Stage stage) {
+        std::vector<float> values;
+        values.reserve(frames.size());
+        for (const Frame& frame : frames) {
+            values.push_back(frame[stage]);
+        }
+        return summarize(std::move(values));
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "core/tracer.hpp"
+
+// Host side timing of the frame loop. Stages are timed with ScopedTimer,
+// summed up per frame and kept in a ring of the last HISTORY frames.
+namespace Profiler {
+    using Clock = std::chrono::steady_clock;
+
+    enum class Stage {
+        Frame,      // Whole iteration of the main loop, from one beginFrame to the next
+        Emulation,  // Emu::stepFrame
+        Ppu,        // Share of the emulation spent in PPU::run, sampled
+        Upload,     // Screen texture upload
+        Render,     // Drawing the screen
+        Ui,         // Building the ImGui frame
+        UiRender,   // Drawing the ImGui frame
+        Swap,       // swapBuffers, includes waiting for vsync
+        Count,
+    };
+
+    size_t constexpr STAGE_COUNT = size_t(Stage::Count);
+    size_t constexpr HISTORY = 512;
+
+    extern const char* const STAGE_NAMES[STAGE_COUNT];
+
+    struct Frame {
+        std::array<float, STAGE_COUNT> ms = {};
+
+        float operator[](Stage stage) const { return ms[size_t(stage)]; }
+    };
+
+    struct Summary {
+        float average = 0;
+        float p50 = 0;
+        float p95 = 0;
+        float p99 = 0;
+        float max = 0;
+    };
+
+    namespace detail {
+        extern std::atomic<bool> enabled;
+    }
+
+    inline bool isEnabled() { return detail::enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool enabled);
+
+    // Closes the running frame and starts the next one, called by the main loop
+    void beginFrame();
+
+    // Adds to the running frame, safe from any thread
+    void add(Stage stage, Clock::duration duration);
+
+    // Oldest frame first. Frames are written without locks, so a reader that
+    // falls behind by a whole ring may see a frame that is being overwritten.
+    void getHistory(std::vector<Frame>& frames);
+
+    Summary summarize(std::vector<float> values);
+    Summary summarize(const std::vector<Frame>& frames, Stage stage);
+
+    // Adds the lifetime of the timer to a stage if profiling was on when it started.
+    // A timer around every n-th call estimates the total with a scale of n. Unscaled
+    // timers also show up as spans while a trace is recorded.
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Stage stage, unsigned int scale = 1)
+            : m_stage(stage), m_scale(scale), m_active(isEnabled()), m_traced(scale == 1 && Tracer::isEnabled()) {
+            if (m_active || m_traced) {
+                m_start = Clock::now();
+            }
+        }
+
+        ~ScopedTimer() { stop(); }
+
+        // Ends the timing before the end of the scope
+        void stop() {
+            if (m_active || m_traced) {
+                Clock::time_point end = Clock::now();
+                if (m_active) {
+                    add(m_stage, (end - m_start) * m_scale);
+                }
+                if (m_traced) {
+                    Tracer::complete(STAGE_NAMES[size_t(m_stage)], "frame", m_start, end);
+                }
+                m_active = m_traced = false;
+            }
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Stage m_stage;
+        unsigned int m_scale;
+        bool m_active;
+        bool m_traced;
+        Clock::time_point m_start;
+    };
+}
@@ -0,0 +1,170 @@
+#include <climits>
+
+#include "sharedmemory.hpp"
+#include "util.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+using namespace Util;
+
+SharedMemory::~SharedMemory() {
+    close();
+}
+
+NamedSemaphore::~NamedSemaphore() {
+    close();
+}
+
+#ifdef _WIN32
+
+// Names are local to the session, the same names as on POSIX but without the slash
+static std::wstring localName(const std::string& name) {
+    return L"Local\\" + std::wstring(name.begin() + (name[0] == '/' ? 1 : 0), name.end());
+}
+
+bool SharedMemory::create(const std::string& name, size_t length) {
+    close();
+
+    m_mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                   DWORD(uint64_t(length) >> 32), DWORD(length & 0xffffffff),
+                                   localName(name).c_str());
+    if (m_mapping != nullptr) {
+        m_data = (uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, length);
+    }
+    if (m_data == nullptr) {
+        LOG_ERR << "Could not create shared memory " << name << "\n";
+        close();
+        return false;
+    }
+
+    m_size = length;
+    return true;
+}
+
+void SharedMemory::close() {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+    }
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_size = 0;
+}
+
+bool NamedSemaphore::create(const std::string& name) {
+    close();
+
+    m_handle = CreateSemaphoreW(nullptr, 0, LONG_MAX, localName(name).c_str());
+    if (m_handle == nullptr) {
+        LOG_ERR << "Could not create semaphore " << name << "\n";
+        return false;
+    }
+    return true;
+}
+
+void NamedSemaphore::close() {
+    if (m_handle) {
+        CloseHandle(m_handle);
+    }
+    m_handle = nullptr;
+}
+
+void NamedSemaphore::post() {
+    ReleaseSemaphore(m_handle, 1, nullptr);
+}
+
+bool NamedSemaphore::wait() {
+    return WaitForSingleObject(m_handle, INFINITE) == WAIT_OBJECT_0;
+}
+
+#else
+
+bool SharedMemory::create(const std::string& name, size_t length) {
+    close();
+
+    // A region left behind by a crashed run is replaced
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        LOG_ERR << "Could not create shared memory " << name << "\n";
+        return false;
+    }
+    m_name = name;
+
+    void* data = MAP_FAILED;
+    if (ftruncate(fd, off_t(length)) == 0) {
+        data = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        LOG_ERR << "Could not map shared memory " << name << "\n";
+        close();
+        return false;
+    }
+
+    m_data = (uint8_t*)data;
+    m_size = length;
+    return true;
+}
+
+void SharedMemory::close() {
+    if (m_data) {
+        munmap(m_data, m_size);
+    }
+    if (!m_name.empty()) {
+        shm_unlink(m_name.c_str());
+    }
+    m_data = nullptr;
+    m_name.clear();
+    m_size = 0;
+}
+
+bool NamedSemaphore::create(const std::string& name) {
+    close();
+
+    sem_unlink(name.c_str());
+    sem_t* sem = sem_open(name.c_str(), O_CREAT | O_EXCL, 0600, 0);
+    if (sem == SEM_FAILED) {
+        LOG_ERR << "Could not create semaphore " << name << "\n";
+        return false;
+    }
+    m_sem = sem;
+    m_name = name;
+    return true;
+}
+
+void NamedSemaphore::close() {
+    if (m_sem) {
+        sem_close((sem_t*)m_sem);
+        sem_unlink(m_name.c_str());
+    }
+    m_sem = nullptr;
+    m_name.clear();
+}
+
+void NamedSemaphore::post() {
+    sem_post((sem_t*)m_sem);
+}
+
+bool NamedSemaphore::wait() {
+    // Retried when a signal interrupts the wait
+    int result;
+    do {
+        result = sem_wait((sem_t*)m_sem);
+    } while (result != 0 && errno == EINTR);
+    return result == 0;
+}
+
+#endif
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace Util {
+    // Named memory shared with other processes on this machine. The creator
+    // owns the name, it is removed again when the creator closes the region.
+    class SharedMemory {
+    public:
+        SharedMemory() = default;
+        ~SharedMemory();
+
+        SharedMemory(const SharedMemory&) = delete;
+        SharedMemory& operator=(const SharedMemory&) = delete;
+
+        // Creates a zero filled region of length bytes
+        bool create(const std::string& name, size_t length);
+        void close();
+
+        bool isOpen() const { return m_data != nullptr; }
+        uint8_t* data() const { return m_data; }
+        size_t size() const { return m_size; }
+
+    private:
+        uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+
+#ifdef _WIN32
+        void* m_mapping = nullptr;
+#else
+        std::string m_name;
+#endif
+    };
+
+    // Counting semaphore other processes can open by name
+    class NamedSemaphore {
+    public:
+        NamedSemaphore() = default;
+        ~NamedSemaphore();
+
+        NamedSemaphore(const NamedSemaphore&) = delete;
+        NamedSemaphore& operator=(const NamedSemaphore&) = delete;
+
+        bool create(const std::string& name);
+        void close();
+
+        void post();
+        bool wait();
+
+    private:
+#ifdef _WIN32
+        void* m_handle = nullptr;
+#else
+        void* m_sem = nullptr;  // sem_t*
+        std::string m_name;
+#endif
+    };
+}
@@ -0,0 +1,131 @@
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "core/util.hpp"
+#include "core/tracer.hpp"
+
+namespace Tracer {
+    namespace detail {
+        std::atomic<bool> enabled = false;
+    }
+
+    // About 48 MB per thread, later events are dropped
+    static size_t constexpr MAX_EVENTS = 1 << 20;
+
+    struct Event {
+        char phase;
+        const char* name;
+        const char* category;
+        Clock::time_point time;
+        Clock::duration duration;
+        double value;
+    };
+
+    // Only contended while a recording starts or is written out
+    struct ThreadBuffer {
+        std::mutex mutex;
+        unsigned int id = 0;
+        std::string name;
+        std::vector<Event> events;
+        size_t dropped = 0;
+    };
+
+    static std::mutex buffersMutex;
+    static std::vector<std::shared_ptr<ThreadBuffer>> buffers;  // Outlive their threads until written
+    static Clock::time_point origin;
+
+    static ThreadBuffer& localBuffer() {
+        thread_local std::shared_ptr<ThreadBuffer> buffer;
+        if (!buffer) {
+            buffer = std::make_shared<ThreadBuffer>();
+            std::lock_guard<std::mutex> lock(buffersMutex);
+            buffer->id = (unsigned int)buffers.size() + 1;
+            buffer->name = "Thread " + std::to_string(buffer->id);
+            buffers.push_back(buffer);
+        }
+        return *buffer;
+    }
+
+    void detail::record(char phase, const char* name, const char* category,
+                        Clock::time_point time, Clock::duration duration, double value) {
+        ThreadBuffer& buffer = localBuffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        if (buffer.events.size() < MAX_EVENTS) {
+            buffer.events.push_back({ phase, name, category, time, duration, value });
+        } else {
+            buffer.dropped++;
+        }
+    }
+
+    void setThreadName(const char* name) {
+        ThreadBuffer& buffer = localBuffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        buffer.name = name;
+    }
+
+    void start() {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for (auto& buffer : buffers) {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            buffer->events.clear();
+            buffer->dropped = 0;
+        }
+        origin = Clock::now();
+        detail::enabled.store(true, std::memory_order_relaxed);
+    }
+
+    static double micros(Clock::duration duration) {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    }
+
+    bool stop(const std::filesystem::path& path) {
+        detail::enabled.store(false, std::memory_order_relaxed);
+
+        FILE* file = fopen(path.string().c_str(), "w");
+        if (!file) {
+            LOG_ERR << "Could not write trace " << path << "\n";
+            return false;
+        }
+
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"sta\"}}");
+
+        size_t count = 0;
+        size_t dropped = 0;
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for (auto& buffer : buffers) {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                    buffer->id, buffer->name.c_str());
+
+            for (const Event& event : buffer->events) {
+                fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%.3f",
+                        event.name, event.category, event.phase, buffer->id, micros(event.time - origin));
+                switch (event.phase) {
+                case 'X': fprintf(file, ",\"dur\":%.3f}", micros(event.duration)); break;
+                case 'C': fprintf(file, ",\"args\":{\"value\":%g}}", event.value); break;
+                case 'i': fprintf(file, ",\"s\":\"t\"}"); break;
+                default:  fprintf(file, "}"); break;
+                }
+            }
+
+            count += buffer->events.size();
+            dropped += buffer->dropped;
+            buffer->events.clear();
+            buffer->events.shrink_to_fit();
+        }
+
+        fprintf(file, "\n]}\n");
+        bool written = !ferror(file);
+        fclose(file);
+
+        LOG_MSG << "Wrote " << count << " trace events to " << path << "\n";
+        if (dropped > 0) {
+            LOG_ERR << dropped << " trace events did not fit into the buffers\n";
+        }
+        return written;
+    }
+}
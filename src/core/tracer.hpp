@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+
+// Records spans, instants and counters into per-thread buffers and writes them
+// as Trace Event JSON for chrome://tracing or Perfetto. While not recording
+// every call is a single relaxed load. Names and categories are not copied,
+// they must be string literals.
+namespace Tracer {
+    using Clock = std::chrono::steady_clock;
+
+    namespace detail {
+        extern std::atomic<bool> enabled;
+
+        void record(char phase, const char* name, const char* category,
+                    Clock::time_point time, Clock::duration duration = {}, double value = 0);
+    }
+
+    inline bool isEnabled() { return detail::enabled.load(std::memory_order_relaxed); }
+
+    // Drops the events of an earlier recording and starts a new one
+    void start();
+    // Stops recording and writes all events, false if the file could not be written
+    bool stop(const std::filesystem::path& path);
+
+    // Shown as the name of the calling thread's track
+    void setThreadName(const char* name);
+
+    // A span across calls, begin and end have to happen on the same thread
+    inline void begin(const char* name, const char* category) {
+        if (isEnabled()) detail::record('B', name, category, Clock::now());
+    }
+
+    inline void end(const char* name, const char* category) {
+        if (isEnabled()) detail::record('E', name, category, Clock::now());
+    }
+
+    inline void instant(const char* name, const char* category) {
+        if (isEnabled()) detail::record('i', name, category, Clock::now());
+    }
+
+    inline void counter(const char* name, double value) {
+        if (isEnabled()) detail::record('C', name, "counter", Clock::now(), {}, value);
+    }
+
+    inline void complete(const char* name, const char* category, Clock::time_point start, Clock::time_point end) {
+        if (isEnabled()) detail::record('X', name, category, start, end - start);
+    }
+
+    // Records its lifetime if recording was on when it started
+    class Span {
+    public:
+        Span(const char* name, const char* category)
+            : m_name(name), m_category(category), m_active(isEnabled()) {
+            if (m_active) {
+                m_start = Clock::now();
+            }
+        }
+
+        ~Span() {
+            if (m_active) {
+                complete(m_name, m_category, m_start, Clock::now());
+            }
+        }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        const char* m_name;
+        const char* m_category;
+        bool m_active;
+        Clock::time_point m_start;
+    };
+}
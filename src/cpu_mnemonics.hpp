@@ -28,7 +28,7 @@ namespace Opcode {
     #define _X16  "%04X"
     #define _S    "%s"
 
-    const char* paramPatterns[][3] = {
+    static const char* paramPatterns[][3] = {
         { nullptr,        nullptr,    nullptr        },
         { "$" _X8 _X8,    _S,         _X8 ":" _X16   },
         { "$" _X8 _X8 ", X", "%s, X",    _X8 ":" _X16 ", X" },
@@ -43,7 +43,7 @@ namespace Opcode {
         { "#$%02X",       nullptr,    nullptr        },
     };
 
-    const char* mnemonics[0x100] = {
+    static const char* mnemonics[0x100] = {
         //          0       1      2       3      4      5       6      7         8      9       a        b       c      d      e      f
         /* 0 */    "BRK",  "ORA", "???", "*SLO", "*NOP", "ORA", "ASL", "*SLO",   "PHP", "ORA",  "ASL A", "???",  "*NOP","ORA", "ASL", "*SLO",
         /* 1 */    "BPL",  "ORA", "???", "*SLO", "*NOP", "ORA", "ASL", "*SLO",   "CLC", "ORA",  "*NOP",  "*SLO", "*NOP","ORA", "ASL", "*SLO",
@@ -1,21 +1,24 @@
 #include <cstdio>
 #include <cassert>
+#include <algorithm>
 #include <string>
 #include <map>
 #include <memory>
+#include <json.hpp>
 
 #include "disasm.hpp"
+#include "analysis.hpp"
 
 #include "emu.hpp"
 #include "rom.hpp"
 #include "mem.hpp"
 #include "ppu.hpp"
+#include "cdl.hpp"
+#include "core/util.hpp"
 #include "cpu_opcodes.hpp"
 #include "cpu_mnemonics.hpp"
 
 
-using DisasmSegmentSptr = std::shared_ptr<DisasmSegment>;
-
 static size_t constexpr BUFLEN = 0xff;
 
 static std::map<int, const char*> inbuiltLabels = {
@@ -53,16 +56,31 @@ Disassembler::Disassembler(Emu& emu) : m_emu(emu) {
     m_translateCartSpace = Settings::get("disassembler/translate-cart-space", true);
     m_showAbsoluteLabels = Settings::get("disassembler/show-absolute-labels", true);
     m_absoluteBranchAddresses = Settings::get("disassembler/absolute-branch-addresses", true);
+    m_staticAnalysis = Settings::get("disassembler/static-analysis", true);
 }
 
+Disassembler::~Disassembler() {}
+
 void Disassembler::writeSettings() {
     Settings::set("disassembler/translate-cart-space", m_translateCartSpace);
     Settings::set("disassembler/show-absolute-labels", m_showAbsoluteLabels);
     Settings::set("disassembler/absolute-branch-addresses", m_absoluteBranchAddresses);
+    Settings::set("disassembler/static-analysis", m_staticAnalysis);
 }
 
-bool Disassembler::translateToCartSpace(uint16_t address) const { 
-    return m_translateCartSpace && Memory::isCartSpace(address); 
+bool Disassembler::translateToCartSpace(DisasmKey key) const { 
+    return m_translateCartSpace && isRomKey(key); 
+}
+
+DisasmKey Disassembler::toKey(uint16_t address) const {
+    if (address < 0x8000 || !m_emu.m_cart) {
+        return DISASM_CPU_SPACE | address;
+    }
+
+    uint8_t cartBank;
+    uint16_t cartAddress;
+    m_emu.m_cart->translate_cpu(address, cartBank, cartAddress);
+    return DisasmKey(cartBank) * PRG_BANK_SIZE + cartAddress;
 }
 
 #define _DISASM_APPEND_(...) (bufIdx += snprintf(&buf[bufIdx], BUFLEN - bufIdx, __VA_ARGS__))
@@ -70,36 +88,40 @@ bool Disassembler::translateToCartSpace(uint16_t address) const {
     _DISASM_APPEND_("%02X        ", opc);\
     _DISASM_APPEND_(Opcode::mnemonics[opc]); }
 #define _DISASM_OP1_ { \
-    arg0 = m_emu.getImmediateArg(address, 0); \
     _DISASM_APPEND_("%02X %02X     ", opc, arg0); \
     _DISASM_APPEND_(Opcode::mnemonics[opc]); \
     _DISASM_APPEND_(" "); }
 #define _DISASM_OP2_ { \
-    arg0 = m_emu.getImmediateArg(address, 0); \
-    arg1 = m_emu.getImmediateArg(address, 1); \
     _DISASM_APPEND_("%02X %02X %02X  ", opc, arg0, arg1); \
     _DISASM_APPEND_(Opcode::mnemonics[opc]); \
     _DISASM_APPEND_(" "); }
 
-const char* Disassembler::disasmOpcode(uint16_t address, bool* end, uint8_t* next) {
-    static uint8_t cartBank;
-    static uint16_t cartAddress;
+void Disassembler::readOpcode(uint16_t address, DisasmLine& line) {
+    line.key = toKey(address);
+    line.offset = address;
+    line.bytes[0] = m_emu.getOpcode(address);
+    line.size = Opcode::paramCount[Opcode::addressingModes[line.bytes[0]]] + 1;
+    line.bytes[1] = line.size > 1 ? m_emu.getImmediateArg(address, 0) : 0;
+    line.bytes[2] = line.size > 2 ? m_emu.getImmediateArg(address, 1) : 0;
+}
 
-    uint8_t opc = m_emu.getOpcode(address);
+// Formats from the bytes stored in the line, so lines of banks that are
+// currently not mapped can be reformatted without touching memory
+const char* Disassembler::formatOpcode(const DisasmLine& line) {
+    uint8_t opc = line.bytes[0];
+    uint8_t arg0 = line.bytes[1];
+    uint8_t arg1 = line.bytes[2];
     Opcode::AddressingMode opc_addressingMode = Opcode::addressingModes[opc];
     uint8_t opc_ac = Opcode::paramCount[opc_addressingMode];
 
     static char buf[BUFLEN];
     int bufIdx = 0;
-    if (translateToCartSpace(address)) {
-        m_emu.m_cart->translate_cpu(address, cartBank, cartAddress);
-        _DISASM_APPEND_("%02X:%04X  ", cartBank, cartAddress);
+    if (translateToCartSpace(line.key)) {
+        _DISASM_APPEND_("%02X:%04X  ", unsigned(line.key / PRG_BANK_SIZE), unsigned(line.key % PRG_BANK_SIZE));
     } else {
-        _DISASM_APPEND_("%04X  ", address);
+        _DISASM_APPEND_("%04X  ", line.offset);
     }
 
-    static uint8_t args[2];
-    static uint8_t arg0, arg1;
     switch (opc_addressingMode) {
     case Opcode::Undefined:
     case Opcode::Implicit:
@@ -108,10 +130,10 @@ const char* Disassembler::disasmOpcode(uint16_t address, bool* end, uint8_t* nex
     case Opcode::Relative:
         if (m_absoluteBranchAddresses) {
             _DISASM_OP1_;
-            uint16_t absoluteAddress = address + opc_ac + 1 + int8_t(arg0);
-            if (translateToCartSpace(absoluteAddress)) {
-                m_emu.m_cart->translate_cpu(absoluteAddress, cartBank, cartAddress);
-                _DISASM_APPEND_(Opcode::paramPatterns[opc_addressingMode][2], cartBank, cartAddress);
+            uint16_t absoluteAddress = line.offset + opc_ac + 1 + int8_t(arg0);
+            DisasmKey key = toKey(absoluteAddress);
+            if (translateToCartSpace(key)) {
+                _DISASM_APPEND_(Opcode::paramPatterns[opc_addressingMode][2], key / PRG_BANK_SIZE, key % PRG_BANK_SIZE);
             } else {
                 _DISASM_APPEND_(Opcode::paramPatterns[opc_addressingMode][1], absoluteAddress);
             }
@@ -132,11 +154,11 @@ const char* Disassembler::disasmOpcode(uint16_t address, bool* end, uint8_t* nex
     case Opcode::Indirect: {
         _DISASM_OP2_;
         uint16_t opcAddress = arg1 << 8 | arg0;
+        DisasmKey key = toKey(opcAddress);
         if (m_showAbsoluteLabels && inbuiltLabels[opcAddress]) {
             _DISASM_APPEND_(Opcode::paramPatterns[opc_addressingMode][1], inbuiltLabels[opcAddress]);
-        } else if (translateToCartSpace(opcAddress)) {
-            m_emu.m_cart->translate_cpu(opcAddress, cartBank, cartAddress);
-            _DISASM_APPEND_(Opcode::paramPatterns[opc_addressingMode][2], cartBank, cartAddress);
+        } else if (translateToCartSpace(key)) {
+            _DISASM_APPEND_(Opcode::paramPatterns[opc_addressingMode][2], key / PRG_BANK_SIZE, key % PRG_BANK_SIZE);
         } else {
             _DISASM_APPEND_(Opcode::paramPatterns[opc_addressingMode][0], arg1, arg0);
         }
@@ -144,15 +166,22 @@ const char* Disassembler::disasmOpcode(uint16_t address, bool* end, uint8_t* nex
     }
     }
 
+    return buf;
+}
+
+const char* Disassembler::disasmOpcode(uint16_t address, bool* end, uint8_t* next) {
+    DisasmLine line;
+    readOpcode(address, line);
+
     if (next) {
-        *next = opc_ac + 1;
+        *next = line.size;
     }
     
-    if (isFlowBreaking(opc) && end) {
+    if (isFlowBreaking(line.bytes[0]) && end) {
         *end = true;
     }
 
-    return buf;
+    return formatOpcode(line);
 }
 
 void Disassembler::logState(std::ostream& os) {
@@ -180,77 +209,292 @@ const char* Disassembler::disasmNextOpcode(bool* end, uint8_t* next) {
     return disasmOpcode(m_emu.getOpcodeAddress(), end, next);
 }
 
-DisasmSegmentSptr Disassembler::findSegment(uint16_t addr, bool& adjacent) {
-    for (auto const& segment: m_disassembly) {
-        uint16_t start = segment.first;
-        uint16_t end = start + segment.second->m_length;
-        if (addr >= start && addr <= end) {
-            adjacent = addr == end;
-            return segment.second;
+const char* Disassembler::getText(const DisasmLine& line) {
+    if (line.reprGeneration != m_formatGeneration) {
+        snprintf(line.repr, DISASM_REPR_LEN, "%s", formatOpcode(line));
+        line.reprGeneration = m_formatGeneration;
+    }
+    return line.repr;
+}
+
+const DisasmLine* DisasmSegment::findLine(DisasmKey key) const {
+    auto it = std::lower_bound(m_lines.begin(), m_lines.end(), key,
+        [](const DisasmLine& line, DisasmKey key) { return line.key < key; });
+    return (it != m_lines.end() && it->key == key) ? &*it : nullptr;
+}
+
+// Index of the segment containing key, or ending directly before it.
+// Returns the number of segments if there is none.
+size_t Disassembler::findSegment(DisasmKey key, bool& adjacent) const {
+    auto it = std::upper_bound(m_disassembly.begin(), m_disassembly.end(), key,
+        [](DisasmKey key, const DisasmSegment& segment) { return key < segment.m_key; });
+    if (it != m_disassembly.begin()) {
+        --it;
+        if (key <= it->endKey()) {
+            adjacent = key == it->endKey();
+            return it - m_disassembly.begin();
         }
     }
 
-    return nullptr;
+    return m_disassembly.size();
 }
 
-void Disassembler::mergeSegments(DisasmSegmentSptr segment, DisasmSegmentSptr other) {
-    segment->m_lines.insert(other->m_lines.begin(), other->m_lines.end());
-    segment->m_length += other->m_length;
+// Appends the segment following index to it
+void Disassembler::mergeSegments(size_t index) {
+    DisasmSegment& segment = m_disassembly[index];
+    DisasmSegment& other = m_disassembly[index + 1];
+    segment.m_lines.insert(segment.m_lines.end(), other.m_lines.begin(), other.m_lines.end());
+    segment.m_length = other.endKey() - segment.m_key;
+    m_disassembly.erase(m_disassembly.begin() + index + 1);
 }
 
-DisasmSegmentSptr Disassembler::disasmSegment(uint16_t addr) {
+const DisasmSegment* Disassembler::disasmSegment(uint16_t addr) {
+    DisasmKey key = toKey(addr);
     bool adjacent;
-    DisasmSegmentSptr segment = findSegment(addr, adjacent);
-    if (segment) {
+    size_t index = findSegment(key, adjacent);
+    if (index < m_disassembly.size()) {
         if (!adjacent) {
-            return segment;
+            return &m_disassembly[index];
         }
         // If adjacent, addr starts directly after segment, 
         // so we simply enhance that one
     } else {
-        segment = std::make_shared<DisasmSegment>(addr);
-        m_disassembly.insert({ addr, segment });
+        auto it = std::upper_bound(m_disassembly.begin(), m_disassembly.end(), key,
+            [](DisasmKey key, const DisasmSegment& segment) { return key < segment.m_key; });
+        it = m_disassembly.emplace(it, addr, key);
+        index = it - m_disassembly.begin();
     }
-    
-    uint8_t next = 0;
+
+    DisasmSegment& segment = m_disassembly[index];
     bool end = false;
+    m_revision++;
 
     do {
-        DisasmLine line{
-            addr, 
-            disasmOpcode(addr, &end, &next) 
-        };
-        segment->m_lines.insert({line.offset, line});
-        addr += next;
-
-        // Check wether current segment is adjacent to an existing segment
-        auto nextSegment = m_disassembly.find(addr);
-        if (nextSegment != m_disassembly.end()) {
-            mergeSegments(segment, nextSegment->second);
-            m_disassembly.erase(addr);
+        DisasmLine line;
+        readOpcode(addr, line);
+        end = isFlowBreaking(line.bytes[0]);
+        segment.m_lines.push_back(line);
+        segment.m_length = line.key + line.size - segment.m_key;
+
+        if (uint32_t(addr) + line.size >= 0xffff) {
+            break;
+        }
+        addr += line.size;
+        key = toKey(addr);
+
+        // Logged code continues past flow breaking opcodes, logged data ends the segment
+        if (m_emu.m_cdl->isCode(addr)) {
+            end = false;
+        } else if (m_emu.m_cdl->isData(addr)) {
             end = true;
-        } else if (addr >= 0xffff) {
+        }
+
+        if (key != line.key + line.size) {
+            // Next address is mapped to another bank
+            end = true;
+        } else if (index + 1 < m_disassembly.size() && key >= m_disassembly[index + 1].m_key) {
+            // Merge if adjacent to the next segment. If the last line overlaps
+            // it instead, the segments are kept apart.
+            if (key == m_disassembly[index + 1].m_key) {
+                mergeSegments(index);
+            }
             end = true;
         }
 
     } while (!end);
 
-    segment->m_length = addr - segment->m_start;
-    return segment;
+    return &m_disassembly[index];
 }
 
-DisasmSegmentSptr Disassembler::continueSegment(DisasmSegmentSptr segment) {
-    return disasmSegment(segment->m_start + segment->m_length);
+const DisasmSegment* Disassembler::continueSegment(const DisasmSegment& segment) {
+    if (toKey(segment.m_start) != segment.m_key) {
+        // The segment's bank is not mapped at its address anymore
+        return &segment;
+    }
+    return disasmSegment(segment.m_start + segment.m_length);
 }
 
+// Lines are formatted again when they are displayed next
 void Disassembler::refresh() {
-    for (auto& segment: m_disassembly) {
-        for (auto& line: segment.second->m_lines) {
-            line.second.repr = disasmOpcode(line.second.offset);
-        }
-    }
+    m_formatGeneration++;
 }
 
 void Disassembler::clear() {
+    m_analysis.reset();
+    m_disassembly.clear();
+    m_revision++;
+}
+
+void Disassembler::analyze() {
+    m_analysis.reset();
+    if (!m_staticAnalysis || !m_emu.m_cart) {
+        return;
+    }
+
+    size_t prgLength = PRG_BANK_SIZE * m_emu.m_cart->prgSize();
+    m_analysis = std::make_unique<StaticAnalysis>(*m_emu.m_cart->m_prgBanks, prgLength, m_emu.m_cdl->prgLog());
+}
+
+bool Disassembler::pollAnalysis() {
+    if (!m_analysis) {
+        return false;
+    }
+
+    StaticAnalysis::Result result = m_analysis->takeResult();
+    if (!result) {
+        return false;
+    }
+
+    m_analysis.reset();
+    insertLines(*result);
+    LOG_MSG << "Static analysis found " << result->size() << " lines\n";
+    return true;
+}
+
+// Rebuilds the segments from the existing and the new lines. Lines overlapping
+// existing ones are dropped, consecutive lines are joined into one segment.
+void Disassembler::insertLines(const std::vector<DisasmLine>& lines) {
+    std::vector<DisasmLine> all;
+    for (auto& segment : m_disassembly) {
+        all.insert(all.end(), segment.m_lines.begin(), segment.m_lines.end());
+    }
+    all.insert(all.end(), lines.begin(), lines.end());
+    std::stable_sort(all.begin(), all.end(),
+        [](const DisasmLine& a, const DisasmLine& b) { return a.key < b.key; });
+
     m_disassembly.clear();
-}
\ No newline at end of file
+    for (auto& line : all) {
+        if (!m_disassembly.empty()) {
+            DisasmSegment& segment = m_disassembly.back();
+            const DisasmLine& last = segment.m_lines.back();
+            if (line.key < segment.endKey()) {
+                continue;
+            }
+            if (line.key == segment.endKey() && line.offset == uint16_t(last.offset + last.size)) {
+                segment.m_lines.push_back(line);
+                segment.m_length = line.key + line.size - segment.m_key;
+                continue;
+            }
+        }
+        m_disassembly.emplace_back(line.offset, line.key);
+        m_disassembly.back().m_lines.push_back(line);
+        m_disassembly.back().m_length = line.size;
+    }
+    m_revision++;
+}
+
+// Only ROM segments are stored, as lines only hold keys and addresses and
+// the bytes are read back from the cart, RAM contents are not persistent.
+bool Disassembler::save(const std::filesystem::path& path, uint32_t crc, const std::vector<DisasmSegment>& disassembly) {
+    nlohmann::json segments = nlohmann::json::array();
+    for (auto& segment : disassembly) {
+        if (!isRomKey(segment.m_key)) {
+            continue;
+        }
+
+        nlohmann::json lines = nlohmann::json::array();
+        for (auto& line : segment.m_lines) {
+            lines.push_back({ line.key, line.offset });
+        }
+        segments.push_back({
+            { "start", segment.m_start },
+            { "key", segment.m_key },
+            { "lines", lines },
+        });
+    }
+
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        LOG_ERR << "Disassembly " << path << " could not be opened.\n";
+        return false;
+    }
+    out << nlohmann::json{ { "crc", crc }, { "segments", segments } };
+    out.close();
+    return true;
+}
+
+bool Disassembler::load(const std::filesystem::path& path, const Cart& cart, std::vector<DisasmSegment>& disassembly) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        return false;
+    }
+
+    nlohmann::json object = nlohmann::json::parse(in, nullptr, false);
+    in.close();
+    if (!object.is_object() || !object["crc"].is_number_unsigned() || object["crc"].get<uint32_t>() != cart.m_crc) {
+        LOG_ERR << "Disassembly " << path << " does not match ROM\n";
+        return false;
+    }
+
+    const uint8_t* prg = *cart.m_prgBanks;
+    size_t prgLength = PRG_BANK_SIZE * cart.prgSize();
+
+    // A file that is valid JSON of the wrong shape is dropped like a mismatching
+    // one. So is one whose segments are not the way save wrote them: in ROM,
+    // sorted, not overlapping and not running past the end of the CPU space.
+    disassembly.clear();
+    const char* error = nullptr;
+    try {
+        for (auto& entry : object["segments"]) {
+            DisasmSegment segment(entry["start"].get<uint16_t>(), entry["key"].get<DisasmKey>());
+            if (!isRomKey(segment.m_key) || segment.m_key >= prgLength) {
+                error = "segment outside of PRG ROM";
+                break;
+            }
+            if (!disassembly.empty() && segment.m_key < disassembly.back().endKey()) {
+                error = "segments unsorted or overlapping";
+                break;
+            }
+
+            for (auto& entryLine : entry["lines"]) {
+                DisasmLine line;
+                line.key = entryLine[0].get<DisasmKey>();
+                line.offset = entryLine[1].get<uint16_t>();
+                if (segment.m_lines.empty() ? line.key != segment.m_key : line.key < segment.endKey()) {
+                    error = "lines unsorted or overlapping";
+                    break;
+                }
+
+                line.bytes[0] = prg[line.key];
+                line.size = Opcode::paramCount[Opcode::addressingModes[line.bytes[0]]] + 1;
+                size_t end = size_t(line.key) + line.size;
+                size_t length = end - segment.m_key;
+                if (end > prgLength || length > 0x10000u - segment.m_start || length > UINT16_MAX) {
+                    error = "line past the end of PRG ROM or the CPU space";
+                    break;
+                }
+                for (uint8_t i = 1; i < 3; i++) {
+                    line.bytes[i] = i < line.size ? prg[line.key + i] : 0;
+                }
+                segment.m_lines.push_back(line);
+                segment.m_length = uint16_t(length);
+            }
+
+            if (!error && segment.m_lines.empty()) {
+                error = "empty segment";
+            }
+            if (error) {
+                break;
+            }
+            disassembly.push_back(std::move(segment));
+        }
+    } catch (const nlohmann::json::exception& e) {
+        LOG_ERR << "Disassembly " << path << " is malformed: " << e.what() << "\n";
+        disassembly.clear();
+        return false;
+    }
+
+    if (error) {
+        LOG_ERR << "Disassembly " << path << " is malformed: " << error << "\n";
+        disassembly.clear();
+        return false;
+    }
+
+    LOG_MSG << "Loaded Disassembly " << path << "\n";
+    return true;
+}
+
+void Disassembler::setDisassembly(std::vector<DisasmSegment> disassembly) {
+    clear();
+    m_disassembly = std::move(disassembly);
+}
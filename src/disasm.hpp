@@ -1,31 +1,54 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
-#include <map>
+#include <memory>
 #include <ostream>
+#include <filesystem>
 
 class Emu;
+class Cart;
+class StaticAnalysis;
+
+// Location of a disassembled byte. ROM is keyed by its offset into PRG ROM
+// (bank * PRG_BANK_SIZE + offset), so lines stay valid across bank switches.
+// Everything else (RAM, PRG RAM) is keyed by CPU address in DISASM_CPU_SPACE.
+using DisasmKey = uint32_t;
+
+DisasmKey constexpr DISASM_CPU_SPACE = 0x1000000;
+
+size_t constexpr DISASM_REPR_LEN = 48;
 
 struct DisasmLine {
-    uint16_t offset;
-    std::string repr;
+    DisasmKey key;
+    uint16_t offset;     // CPU address at the time of disassembly
+    uint8_t size;
+    uint8_t bytes[3];
+
+    // Text cache, filled on demand by Disassembler::getText. Stored inline,
+    // so the lines of a segment are a single allocation.
+    mutable uint32_t reprGeneration = 0;
+    mutable char repr[DISASM_REPR_LEN];
 };
 
+// Consecutive lines covering the keys [m_key, m_key + m_length)
 struct DisasmSegment {
-    uint16_t m_start;
+    uint16_t m_start;    // CPU address at the time of disassembly
+    DisasmKey m_key;
     uint16_t m_length = 0;
 
-    std::map<uint16_t, DisasmLine> m_lines;
+    std::vector<DisasmLine> m_lines;  // Sorted by key
+
+    DisasmSegment(uint16_t start, DisasmKey key) : m_start(start), m_key(key) {}
 
-    DisasmSegment(uint16_t start) : m_start(start) {}
+    DisasmKey endKey() const { return m_key + m_length; }
+    const DisasmLine* findLine(DisasmKey key) const;
 };
 
 class Disassembler {
-
-    using DisasmSegmentSptr = std::shared_ptr<DisasmSegment>;
-
 public:
     Disassembler(Emu& emu);
+    ~Disassembler();
 
     void writeSettings();
 
@@ -34,26 +57,54 @@ public:
     void logState(std::ostream& os);
 
     const char* disasmNextOpcode(bool* end = nullptr, uint8_t* next = nullptr);
-    DisasmSegmentSptr disasmSegment(uint16_t addr);
-    DisasmSegmentSptr continueSegment(DisasmSegmentSptr segment);
+    // Returned segments are valid until the disassembly is modified
+    const DisasmSegment* disasmSegment(uint16_t addr);
+    const DisasmSegment* continueSegment(const DisasmSegment& segment);
+
+    const char* getText(const DisasmLine& line);
+    uint32_t getRevision() const { return m_revision; }  // Changes whenever lines are added or removed
+
+    DisasmKey toKey(uint16_t address) const;
+    static bool isRomKey(DisasmKey key) { return key < DISASM_CPU_SPACE; }
 
     void clear();
     void refresh();
 
+    void analyze();       // Starts the static analysis of the cart in the background
+    bool pollAnalysis();  // Adds the result of the static analysis once it is done, true if lines were added
+
+    // Only touch their arguments, so the files can be read and written on any thread
+    static bool load(const std::filesystem::path& path, const Cart& cart, std::vector<DisasmSegment>& disassembly);
+    static bool save(const std::filesystem::path& path, uint32_t crc, const std::vector<DisasmSegment>& disassembly);
+    void setDisassembly(std::vector<DisasmSegment> disassembly);  // Replaces all lines, e.g. with a loaded disassembly
+
     bool m_translateCartSpace = true;       // Translate Addresses into Cartridge Space if applicable
     bool m_showAbsoluteLabels = true;       // Show Labels for Absolute Addressing
     bool m_absoluteBranchAddresses = true;  // Display absolute Branch Addresses
+    bool m_staticAnalysis = true;           // Analyze reachable code when a cart is loaded
 
-    std::map<uint16_t, DisasmSegmentSptr>::const_iterator begin() const { return m_disassembly.begin(); }
-    std::map<uint16_t, DisasmSegmentSptr>::const_iterator end() const { return m_disassembly.end(); }
+    std::vector<DisasmSegment>::const_iterator begin() const { return m_disassembly.begin(); }
+    std::vector<DisasmSegment>::const_iterator end() const { return m_disassembly.end(); }
+    size_t size() const { return m_disassembly.size(); }
 
 private:
     Emu& m_emu;
 
-    std::map<uint16_t, DisasmSegmentSptr> m_disassembly;
+    // Non-overlapping segments sorted by key, looked up by binary search
+    std::vector<DisasmSegment> m_disassembly;
+
+    uint32_t m_revision = 0;
+    uint32_t m_formatGeneration = 1;  // Lines with another generation are formatted again
+
+    std::unique_ptr<StaticAnalysis> m_analysis;
+
+    void insertLines(const std::vector<DisasmLine>& lines);
+
+    size_t findSegment(DisasmKey key, bool& adjacent) const;
+    void mergeSegments(size_t index);
 
-    DisasmSegmentSptr findSegment(uint16_t addr, bool& adjacent);
-    void mergeSegments(DisasmSegmentSptr segment, DisasmSegmentSptr other);
+    void readOpcode(uint16_t address, DisasmLine& line);
+    const char* formatOpcode(const DisasmLine& line);
 
-    bool translateToCartSpace(uint16_t address) const;
+    bool translateToCartSpace(DisasmKey key) const;
 };
@@ -1,26 +1,45 @@
 #include <iostream>
+#include <miniz.h>
 
 #include "emu.hpp"
 #include "mem.hpp"
 #include "rom.hpp"
 #include "ppu.hpp"
 #include "core/util.hpp"
+#include "core/profiler.hpp"
+#include "core/tracer.hpp"
+#include "core/probes.hpp"
 #include "cpu_opcodes.hpp"
 #include "disasm.hpp"
+#include "cdl.hpp"
 #include "controllers.hpp"
 
 namespace sm = StreamManipulators;
 
-Emu::Emu() {
+Emu::Emu() : Emu(Config{
+    Settings::get("emulator/code-data-logger", true),
+    Settings::get("emulator/frame-hashes", false),
+    Settings::get("emulator/skip-idle-loops", true) }) {
     m_breakOnInterrupt = Settings::get("emulator/break-on-interrupt", false);
     m_logOut.open("cpu.log");
+}
+
+Emu::Emu(const Config& config) {
     m_disassembler = std::make_unique<Disassembler>(*this);
+    m_cdl = std::make_unique<CodeDataLog>();
+    m_cdl->m_enabled = config.codeDataLogger;
+    m_hashFrames = config.hashFrames;
+    m_skipIdleLoops = config.skipIdleLoops;
 
-    m_ports[0] = std::make_shared<Controller>(Input::getState().input0);
-    m_ports[1] = std::make_shared<Controller>(Input::getState().input1);
+    m_ports[0] = std::make_shared<Controller>(m_inputs[0]);
+    m_ports[1] = std::make_shared<Controller>(m_inputs[1]);
 }
 
 Emu::~Emu() {
+    saveAnalysis();
+    if (m_saving.valid()) {
+        m_saving.wait();
+    }
     m_logOut.close();
 }
 
@@ -33,31 +52,219 @@ void Emu::setPixelFn(std::function<void(unsigned int, unsigned int, unsigned int
 
 void Emu::writeSettings() {
     Settings::set("emulator/break-on-interrupt", m_breakOnInterrupt);
+    Settings::set("emulator/code-data-logger", m_cdl->m_enabled);
+    Settings::set("emulator/frame-hashes", m_hashFrames);
+    Settings::set("emulator/skip-idle-loops", m_skipIdleLoops);
     m_disassembler->writeSettings();
 }
 
+// Analysis results are stored in sidecar files next to the ROM. That may be a
+// slow network drive, so a copy of them is written on a worker.
+void Emu::saveAnalysis() {
+    if (!isInitialized() || m_romPath.empty()) {
+        return;
+    }
+
+    // One save at a time, so the files are never written twice at once
+    if (m_saving.valid()) {
+        m_saving.wait();
+    }
+    m_saving = std::async(std::launch::async,
+        [path = m_romPath, crc = m_cart->m_crc, codeDataLog = *m_cdl,
+         disassembly = std::vector<DisasmSegment>(m_disassembler->begin(), m_disassembler->end())]() mutable {
+        Tracer::setThreadName("Analysis Writer");
+        Tracer::Span span("Save Analysis", "io");
+        codeDataLog.save(path.replace_extension(".cdl"));
+        Disassembler::save(path.replace_extension(".disasm.json"), crc, disassembly);
+    }).share();
+}
+
+Emu::LoadedCart Emu::loadCart(const std::filesystem::path& path, std::shared_future<void> saving) {
+    LoadedCart loaded;
+    loaded.cart = Cart::fromFile(path);
+    if (loaded.cart) {
+        if (saving.valid()) {
+            saving.wait();
+        }
+
+        std::filesystem::path sidecar = path;
+        loaded.codeDataLog = std::make_unique<CodeDataLog>();
+        loaded.codeDataLog->reset(loaded.cart);
+        loaded.codeDataLog->load(sidecar.replace_extension(".cdl"));
+        Disassembler::load(sidecar.replace_extension(".disasm.json"), *loaded.cart, loaded.disassembly);
+    }
+    return loaded;
+}
+
 bool Emu::init(const std::filesystem::path& path) {
-    std::shared_ptr<Cart> cart = Cart::fromFile(path);
-    if (cart) {
-        init(cart);
-        return true;
+    return swapCart(loadCart(path, m_saving), path);
+}
+
+bool Emu::swapCart(LoadedCart loaded, const std::filesystem::path& path) {
+    Tracer::Span span("Swap Cart", "io");
+    if (!loaded.cart) {
+        STA_PROBE2(rom__load__end, path.c_str(), 0);
+        return false;
+    }
+
+    if (isInitialized() && path == m_romPath && loaded.cart->m_crc == m_cart->m_crc) {
+        // Reloaded, the analysis in memory is newer than the sidecars that were read
+        loaded.codeDataLog = std::make_unique<CodeDataLog>(*m_cdl);
+        loaded.codeDataLog->setCart(loaded.cart);
+        loaded.disassembly.assign(m_disassembler->begin(), m_disassembler->end());
+    } else {
+        saveAnalysis();
+    }
+
+    bool logging = m_cdl->m_enabled;
+    init(loaded.cart);
+
+    m_romPath = path;
+    m_cdl = std::move(loaded.codeDataLog);
+    m_cdl->m_enabled = logging;
+    m_disassembler->setDisassembly(std::move(loaded.disassembly));
+    m_disassembler->analyze();
+    STA_PROBE2(rom__load__end, path.c_str(), 1);
+    return true;
+}
+
+bool Emu::loadAsync(const std::filesystem::path& path, std::function<void(bool)> onLoaded) {
+    if (isLoading()) {
+        return false;
+    }
+    m_loadingPath = path;
+    m_onLoaded = onLoaded;
+    m_loading = std::async(std::launch::async, [path, saving = m_saving]() {
+        Tracer::setThreadName("ROM Loader");
+        return loadCart(path, saving);
+    });
+    return true;
+}
+
+void Emu::pollLoad() {
+    if (!isLoading() || m_loading.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+
+    bool loaded = swapCart(m_loading.get(), m_loadingPath);
+    if (m_onLoaded) {
+        m_onLoaded(loaded);
+        m_onLoaded = nullptr;
     }
-    return false;
 }
 
 void Emu::init(std::shared_ptr<Cart> cart) {
     m_cart = cart;
+    m_romPath.clear();
+    m_cdl->reset(m_cart);
     m_disassembler->clear();
+    m_movie.stop();
+    powerOn();
+}
+
+// Everything starts from fixed values, so two runs with the same inputs are identical
+void Emu::powerOn() {
+    // Movies must not depend on what the save file holds. Runs without a
+    // window never map one, the GUI keeps its save even with frame hashes on.
+    if (m_movie.isActive()) {
+        m_cart->unmapSave();
+    }
+    m_cart->powerOn();
     m_ppu = std::make_shared<PPU>(*this, m_cart);
     m_mem = std::make_unique<Memory>(*this, m_cart, m_ppu);
     m_mem->setPort0(m_ports[0]);
     m_mem->setPort1(m_ports[1]);
+    m_mem->setRamBuffer(m_ramBuffer);
+    m_ppu->setFrameBuffer(m_frameBuffer);
+    m_ppu->m_skipRender = m_renderSkip;
 
     if (m_setPixel) {
         m_ppu->setPixelFn(m_setPixel);
     }
 
+    m_pc = 0x0000;
+    m_sp = 0x00;
+    m_r_a = m_r_x = m_r_y = 0x00;
+    m_f_carry = m_f_zero = m_f_overflow = m_f_negative = false;
+    m_nextOpcode = 0;
+    m_nextOpcodeAddress = 0;
+
     reset();
+
+    m_frameHashes.clear();
+    m_inputFrame = m_ppu->isOddFrame();
+    sampleInputs();
+}
+
+void Emu::setOutputBuffers(uint8_t* ram, uint8_t* frame) {
+    m_ramBuffer = ram;
+    m_frameBuffer = frame;
+    // A running emulator takes its current RAM and frame along
+    if (m_mem) {
+        m_mem->setRamBuffer(ram);
+    }
+    if (m_ppu) {
+        m_ppu->setFrameBuffer(frame);
+    }
+}
+
+void Emu::setRenderSkip(bool skip) {
+    m_renderSkip = skip;
+    if (m_ppu) {
+        m_ppu->m_skipRender = skip;
+    }
+}
+
+void Emu::setFrameInputs(const Input::Controller& input0, const Input::Controller& input1) {
+    m_manualInputs[0] = input0;
+    m_manualInputs[1] = input1;
+    m_inputs[0] = input0;
+    m_inputs[1] = input1;
+}
+
+bool Emu::recordMovie() {
+    if (!isInitialized()) {
+        return false;
+    }
+    m_movie.record(m_cart->m_crc);
+    powerOn();
+    return true;
+}
+
+bool Emu::playMovie() {
+    if (!isInitialized() || m_movie.frameCount() == 0) {
+        return false;
+    }
+    if (m_movie.romCrc() != m_cart->m_crc) {
+        LOG_ERR << "Movie was recorded with a different ROM.\n";
+        return false;
+    }
+    m_movie.play();
+    powerOn();
+    return true;
+}
+
+std::filesystem::path Emu::getSidecarPath(const char* extension) const {
+    std::filesystem::path path = m_romPath;
+    return path.replace_extension(extension);
+}
+
+uint32_t Emu::hashState() const {
+    const uint8_t cpu[] = {
+        uint8_t(m_pc), uint8_t(m_pc >> 8), m_sp, m_r_a, m_r_x, m_r_y, getProcStatus(false),
+    };
+
+    mz_ulong crc = mz_crc32(MZ_CRC32_INIT, cpu, sizeof(cpu));
+    crc = mz_crc32(crc, m_mem->m_internalRam, Memory::INTERNAL_RAM_SIZE);
+    crc = mz_crc32(crc, m_cart->prgRam(), PRG_RAM_SIZE);
+    return m_ppu->hashState(uint32_t(crc));
+}
+
+void Emu::sampleInputs() {
+    const Input::State& state = Input::getState();
+    m_inputs[0] = state.input0 | m_manualInputs[0];
+    m_inputs[1] = state.input1 | m_manualInputs[1];
+    m_movie.frame(m_inputs);
 }
 
 bool Emu::toggleBreakpoint(uint16_t address) {
@@ -80,12 +287,12 @@ bool Emu::isInitialized() {
 }
 
 uint8_t Emu::getOpcode() { return m_nextOpcode; }
-uint8_t Emu::getOpcode(uint16_t addr) { return m_mem->readb(addr); }
+uint8_t Emu::getOpcode(uint16_t addr) { return m_mem->peekb(addr); }
 uint16_t Emu::getOpcodeAddress() { return m_nextOpcodeAddress; }
-uint8_t Emu::getImmediateArg(int offset) { return m_mem->readb(m_pc + offset); }
-uint8_t Emu::getImmediateArg(uint16_t addr, int offset) { return m_mem->readb(addr + 1 + offset); }
+uint8_t Emu::getImmediateArg(int offset) { return m_mem->peekb(m_pc + offset); }
+uint8_t Emu::getImmediateArg(uint16_t addr, int offset) { return m_mem->peekb(addr + 1 + offset); }
 
-uint8_t Emu::getProcStatus(bool setBrk) {
+uint8_t Emu::getProcStatus(bool setBrk) const {
     uint8_t v = 16;  // Bit 5 is always set, see https://wiki.nesdev.com/w/index.php/Status_flags#The_B_flag
     if (m_f_carry)    v |= 1;
     if (m_f_zero)     v |= 2;
@@ -123,27 +330,46 @@ void Emu::reset() {
     // -- Non CPU Stuff
     m_cycleCount = 0;
     m_ppu->reset();
+    m_cart->reset();
 
     // Reset Interrupt Lines
     m_nmi_request = false;
     m_irq_request = false;
     m_intVector = IRQ_VECTOR;
     m_isInterrupt = false;
+
+    m_dmaCycle = DMA_LENGTH;
+
+    m_idleLoop.valid = false;
+    m_idleCycles = 0;
+    m_frameIdleCycles = 0;
 }
 
 void Emu::startDMA(uint8_t page) {
-    // TODO Additional Cycle on odd cpu cycles??
-    m_dmaCycle = -1;
+    m_dmaCycle = DMA_REQUESTED;
     m_dmaPage = page;
 }
 
+// The CPU is halted for 513 cycles, 514 if halted on an odd cycle:
+// one halt cycle, the optional alignment cycle and 256 read/write pairs.
 void Emu::execDma() {
-    if (m_dmaCycle >= 512) {
-        m_mode = Mode::EXEC;
-        return;
-    } 
+    m_cycleCount++;
+
+    if (m_dmaCycle == DMA_REQUESTED) {
+        Tracer::begin("OAM DMA", "emu");
+        STA_PROBE2(dma__start, m_dmaPage, m_cycleCount);
 
-    if (m_dmaCycle >= 0) {
+        // Pages without read side effects are copied at once
+        uint8_t page[0x100];
+        m_dmaBulk = m_mem->readDmaPage(uint8_t(m_dmaPage), page);
+        if (m_dmaBulk) {
+            m_ppu->writeOamDma(page);
+        }
+        m_dmaCycle = (m_cycleCount & 1) ? DMA_ALIGN : 0;
+        return;
+    }
+    
+    if (m_dmaCycle >= 0 && !m_dmaBulk) {
         bool isWrite = m_dmaCycle % 2;  // Alternatingly ...
         if (isWrite) {
             m_mem->writeb(0x2000 | PPU::OAMDATA, uint8_t(_m_lo));   // ... write to OAM
@@ -153,29 +379,101 @@ void Emu::execDma() {
         }
     }
 
-    m_dmaCycle++;
+    if (++m_dmaCycle == DMA_LENGTH) {
+        m_mode = Mode::EXEC;
+        Tracer::end("OAM DMA", "emu");
+        STA_PROBE1(dma__end, m_cycleCount);
+    }
 }
 
 uint8_t Emu::fetchArg() {
-    return m_mem->readb(m_pc++);
+    return m_mem->fetchb(m_pc++);
 }
 
 void Emu::fetch() {
+    uint16_t previousAddress = m_nextOpcodeAddress;
     m_nextOpcodeAddress = m_pc;
-    m_nextOpcode = m_mem->readb(m_pc);
+    m_nextOpcode = m_mem->fetchb(m_pc);
     m_cyclesLeft = OPC_CYCLES[m_nextOpcode];
 
     m_pc++;
     m_lastCycleFetched = true;
 
+    if (m_skipIdleLoops && !m_isStepping) {
+        checkIdleLoop(previousAddress);
+    }
+
     if (m_logState) {
         m_disassembler->logState(m_logOut);
         m_logOut.flush();
     }
 }
 
+// A loop is idle if an iteration returns to its head with the same registers, no
+// writes, only reads of RAM, cartridge and PPUSTATUS, and no PPU event on the way.
+// Every following iteration then does exactly the same until the next PPU event,
+// so the CPU skips whole iterations while the PPU runs on. That keeps the cycle
+// counts and every read in between as they would have been.
+void Emu::checkIdleLoop(uint16_t previousAddress) {
+    bool atHead = m_idleLoop.valid && m_nextOpcodeAddress == m_idleLoop.head;
+    if (!atHead && m_nextOpcodeAddress > previousAddress) {
+        // Only backward jumps and branches start loops
+        return;
+    }
+
+    IdleLoop current;
+    current.valid = true;
+    current.head = m_nextOpcodeAddress;
+    current.a = m_r_a;
+    current.x = m_r_x;
+    current.y = m_r_y;
+    current.sp = m_sp;
+    current.status = getProcStatus(false);
+    current.ppuStatus = m_ppu->peekStatus();
+    current.cycle = m_cycleCount;
+    current.sideEffects = m_mem->m_sideEffects;
+    current.statusReads = m_mem->m_statusReads;
+
+    if (atHead) {
+        unsigned long period = current.cycle - m_idleLoop.cycle;
+        bool idle = current.a == m_idleLoop.a
+                 && current.x == m_idleLoop.x
+                 && current.y == m_idleLoop.y
+                 && current.sp == m_idleLoop.sp
+                 && current.status == m_idleLoop.status
+                 && current.ppuStatus == m_idleLoop.ppuStatus
+                 && current.sideEffects == m_idleLoop.sideEffects
+                 && period <= IDLE_MAX_PERIOD
+                 && period * 3 <= m_idleLoop.quietDots
+                 && m_mode == Mode::EXEC
+                 && m_dmaCycle == DMA_LENGTH
+                 && m_breakpoints.empty()
+                 && !m_logState;
+
+        if (idle) {
+            bool watchStatus = current.statusReads != m_idleLoop.statusReads;
+            unsigned long iterations = m_ppu->dotsUntilEvent(watchStatus, !m_f_irq) / (period * 3);
+            if (iterations > 0) {
+                Profiler::ScopedTimer timer(Profiler::Stage::Ppu);
+                m_ppu->run(iterations * period * 3);
+                m_cycleCount += iterations * period;
+                m_idleCycles += iterations * period;
+                current.cycle = m_cycleCount;
+            }
+        }
+    }
+
+    current.quietDots = m_ppu->dotsUntilEvent(true, !m_f_irq);
+    m_idleLoop = current;
+}
+
 void Emu::requestInterrupt(uint16_t vector) {
     m_interruptInCycle = true;
+    if (vector == NMI_VECTOR) {
+        STA_PROBE2(nmi, m_pc, m_cycleCount);
+    } else {
+        STA_PROBE2(irq, m_pc, m_cycleCount);
+    }
 
     m_nextOpcodeAddress = m_pc;
     m_nextOpcode = OPC_BRK;
@@ -243,6 +541,7 @@ void Emu::stepScanline() {
 }
 
 void Emu::stepFrame() {
+    STA_PROBE1(frame__start, m_cycleCount);
     bool currentFrame = m_ppu->isOddFrame();
 
     while (m_ppu->isOddFrame() == currentFrame) {
@@ -250,6 +549,7 @@ void Emu::stepFrame() {
             break;
         }
     }
+    STA_PROBE1(frame__end, m_cycleCount);
 }
 
 void Emu::stepOut() {
@@ -264,6 +564,16 @@ void Emu::stepOut() {
     m_breakOnRTS = false;
 }
 
+// Timing each step would cost more than the step itself, so the PPU time is sampled
+void Emu::runPpu() {
+    if (Profiler::isEnabled() && m_cycleCount % PPU_SAMPLE_RATE == 0) {
+        Profiler::ScopedTimer timer(Profiler::Stage::Ppu, PPU_SAMPLE_RATE);
+        m_ppu->run(3);
+    } else {
+        m_ppu->run(3);
+    }
+}
+
 bool Emu::stepCycle() {
     bool breakExecution = false;
 
@@ -285,14 +595,14 @@ bool Emu::stepCycle() {
                     // Opcode uses additional cycles
                     m_mode = Mode::CYCLES;
                 }
-            } else if (m_dmaCycle < 0) {
+            } else if (m_dmaCycle == DMA_REQUESTED) {
                 // Instruction's write has triggered OAMDMA
                 m_mode = Mode::DMA;
                 fetch();
             } else if (m_nmi_request) {
                 requestInterrupt(NMI_VECTOR);
                 m_nmi_request = false;
-            } else if (m_irq_request) {
+            } else if ((m_irq_request || m_cart->irqAsserted()) && !m_f_irq) {
                 requestInterrupt(IRQ_VECTOR);
                 m_irq_request = false;
             } else {
@@ -305,13 +615,13 @@ bool Emu::stepCycle() {
         m_cycleCount++;
         if (--m_cyclesLeft == 0) {
             m_mode = Mode::EXEC;
-            if (m_dmaCycle < 0) {
+            if (m_dmaCycle == DMA_REQUESTED) {
                 m_mode = Mode::DMA;
                 fetch();
             } else if (m_nmi_request) {
                 requestInterrupt(NMI_VECTOR);
                 m_nmi_request = false;
-            } else if (m_irq_request) {
+            } else if ((m_irq_request || m_cart->irqAsserted()) && !m_f_irq) {
                 requestInterrupt(IRQ_VECTOR);
                 m_irq_request = false;
             } else {
@@ -332,11 +642,22 @@ bool Emu::stepCycle() {
     // TODO Should start PPU after Reset?
 #ifdef NESTEST_SETUP
     if (m_mode != Mode::RESET) 
-        m_ppu->run(3);
+        runPpu();
 #else
-    m_ppu->run(3);
+    runPpu();
 #endif
 
+    // A new frame has started, inputs only change here so movies can reproduce them
+    if (m_ppu->isOddFrame() != m_inputFrame) {
+        m_inputFrame = m_ppu->isOddFrame();
+        Tracer::counter("Idle Cycles", double(m_idleCycles - m_frameIdleCycles));
+        m_frameIdleCycles = m_idleCycles;
+        if (m_hashFrames) {
+            m_frameHashes.push_back(hashState());
+        }
+        sampleInputs();
+    }
+
     // We are at the start of a new opcode and have hit a breakpoint
     if (m_lastCycleFetched && m_breakpoints.find(m_nextOpcodeAddress) != m_breakpoints.end()
         || (m_interruptInCycle && m_breakOnInterrupt)
@@ -421,6 +742,7 @@ void Emu::execOpcode() {
         m_pc = m_mem->readb(_hilo());
         _m_lo += 1;
         m_pc |= uint16_t(m_mem->readb(_fromHilo())) << 8;
+        m_cdl->logPrg(m_pc, CodeDataLog::PRG_INDIRECT_CODE);
         break;
     case OPC_JSR:
         _toHilo(m_pc + 1);
@@ -741,7 +1063,9 @@ __forceinline void Emu::_readIndX() {
     _m_lo = fetchArg() + m_r_x;
     _m_hi = m_mem->readb((_m_lo + 1) & 0xff);
     _m_lo = m_mem->readb(_m_lo & 0xff);
-    _m_lo = m_mem->readb(_fromHilo());
+    _m_lo = _fromHilo();
+    m_cdl->logPrg(_m_lo, CodeDataLog::PRG_INDIRECT_DATA);
+    _m_lo = m_mem->readb(_m_lo);
 }
 __forceinline void Emu::_readIndY() {
     _m_lo = fetchArg();
@@ -752,6 +1076,7 @@ __forceinline void Emu::_readIndY() {
     if ((_m_lo & 0xff00) != (_m_hi & 0xff00)) {
         m_cyclesLeft++;
     }
+    m_cdl->logPrg(_m_hi, CodeDataLog::PRG_INDIRECT_DATA);
     _m_lo = m_mem->readb(_m_hi);
 }
 
@@ -838,11 +1163,14 @@ __forceinline void Emu::_redrIndY() {
 }
 __forceinline void Emu::_storeReg(const uint8_t& reg) { m_mem->writeb(_m_hi, reg); }
 
-__forceinline void Emu::_redmZpg()  { _redrZpg();  _m_lo = m_mem->readb(_m_hi); }
-__forceinline void Emu::_redmZpgX() { _redrZpgX(); _m_lo = m_mem->readb(_m_hi); }
-__forceinline void Emu::_redmAbs()  { _redrAbs();  _m_lo = m_mem->readb(_m_hi); }
-__forceinline void Emu::_redmAbsX() { _redrAbsX(); _m_lo = m_mem->readb(_m_hi); }
-__forceinline void Emu::_redmAbsY() { _redrAbsY(); _m_lo = m_mem->readb(_m_hi); }
-__forceinline void Emu::_redmIndX() { _redrIndX(); _m_lo = m_mem->readb(_m_hi); }
-__forceinline void Emu::_redmIndY() { _redrIndY(); _m_lo = m_mem->readb(_m_hi); }
+// Read-modify-write instructions write the unmodified value back on the cycle
+// before the result, which registers like the MMC1's see as a second write
+__forceinline void Emu::_redmZpg()  { _redrZpg();  _m_lo = m_mem->readb(_m_hi); _writeBack(); }
+__forceinline void Emu::_redmZpgX() { _redrZpgX(); _m_lo = m_mem->readb(_m_hi); _writeBack(); }
+__forceinline void Emu::_redmAbs()  { _redrAbs();  _m_lo = m_mem->readb(_m_hi); _writeBack(); }
+__forceinline void Emu::_redmAbsX() { _redrAbsX(); _m_lo = m_mem->readb(_m_hi); _writeBack(); }
+__forceinline void Emu::_redmAbsY() { _redrAbsY(); _m_lo = m_mem->readb(_m_hi); _writeBack(); }
+__forceinline void Emu::_redmIndX() { _redrIndX(); _m_lo = m_mem->readb(_m_hi); _writeBack(); }
+__forceinline void Emu::_redmIndY() { _redrIndY(); _m_lo = m_mem->readb(_m_hi); _writeBack(); }
+__forceinline void Emu::_writeBack() { m_mem->writeb(_m_hi, (uint8_t)_m_lo, m_cycleCount - 1); }
 __forceinline void Emu::_storeMem() { m_mem->writeb(_m_hi, (uint8_t)_m_lo); }
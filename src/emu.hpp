@@ -2,17 +2,23 @@
 
 #include <cstdint>
 #include <set>
+#include <vector>
 #include <memory>
 #include <array>
 #include <functional>
 #include <fstream>
+#include <filesystem>
+#include <future>
 
 #include "inputs.hpp"
+#include "movie.hpp"
 
 class Memory;
 class Cart;
 class PPU;
 class Disassembler;
+class CodeDataLog;
+struct DisasmSegment;
 class Port;
 
 uint16_t constexpr NMI_VECTOR = 0xfffa;    // Address where NMI starts
@@ -22,6 +28,7 @@ uint16_t constexpr IRQ_VECTOR = 0xfffe;    // Address where IRQ/BRK starts
 class Emu {
 public:
     std::unique_ptr<Disassembler> m_disassembler;
+    std::unique_ptr<CodeDataLog> m_cdl;
 
     bool m_logState = false;
 
@@ -58,20 +65,72 @@ public:
     bool m_breakOnInterrupt = false;
     bool m_breakOnRTS = false;
 
-    Emu();
+    // Buttons held through the Controls window, combined with the keyboard state
+    std::array<Input::Controller, 2> m_manualInputs;
+
+    Movie m_movie;
+
+    // Collects hashState() at the end of every frame since power on. These include battery RAM, which
+    // only comes from a save file for ROMs opened in the GUI.
+    bool m_hashFrames = false;
+    const std::vector<uint32_t>& getFrameHashes() const { return m_frameHashes; }
+
+    // Fast-forwards loops that only wait for the PPU or an interrupt, with identical results
+    bool m_skipIdleLoops = true;
+    unsigned long getIdleCycles() const { return m_idleCycles; }  // Skipped since the last reset
+
+    // Everything an instance without UI needs configured, the others take it from the settings
+    struct Config {
+        bool codeDataLogger = false;
+        bool hashFrames = false;
+        bool skipIdleLoops = true;
+    };
+
+    Emu();                               // Configured by the settings, logs to cpu.log
+    explicit Emu(const Config& config);  // Ignores the emulator settings and doesn't log, e.g. for headless or batched runs
     ~Emu();
 
     void setPixelFn(std::function<void(unsigned int, unsigned int, unsigned int)>);
 
     void writeSettings();
+    void saveAnalysis();  // Written on a worker, see m_saving
 
     bool toggleBreakpoint(uint16_t address);
     bool isBreakpoint(uint16_t address);
 
     bool init(const std::filesystem::path& path);
     void init(std::shared_ptr<Cart> _cart);
+
+    // Loads a cart on a worker thread, false if another load is pending.
+    // pollLoad swaps it in and calls onLoaded, call it between frames.
+    bool loadAsync(const std::filesystem::path& path, std::function<void(bool)> onLoaded = nullptr);
+    bool isLoading() const { return m_loading.valid(); }
+    void pollLoad();
+
     bool isInitialized();
+    void powerOn();
+
+    // RAM and frame are kept in these buffers from now on, e.g. in memory shared
+    // with another process. nullptr moves them back inside Memory and PPU.
+    void setOutputBuffers(uint8_t* ram, uint8_t* frame);
+
+    // Runs without composing pixels until turned off again, see PPU::m_skipRender
+    void setRenderSkip(bool skip);
+
+    // Holds these buttons from the frame that is about to start, call between frames
+    void setFrameInputs(const Input::Controller& input0, const Input::Controller& input1);
     void reset();
+
+    // Both restart the cart from power on, so the movie covers the whole session
+    bool recordMovie();
+    bool playMovie();
+
+    // Files belonging to the ROM are stored next to it, like the analysis results
+    std::filesystem::path getSidecarPath(const char* extension) const;
+    const std::filesystem::path& getRomPath() const { return m_romPath; }
+
+    // CRC32 over the frame, RAM, VRAM, OAM and registers. Identical runs give identical hashes.
+    uint32_t hashState() const;
     void startDMA(uint8_t page);
     void stepOperation();
     void stepScanline();
@@ -87,14 +146,41 @@ public:
     uint8_t getImmediateArg(int offset); 
     uint8_t getImmediateArg(uint16_t addr, int offset);
 
-    uint8_t getProcStatus(bool setBrk);
+    uint8_t getProcStatus(bool setBrk) const;
 
 private:
     std::ofstream m_logOut;
 
+    std::filesystem::path m_romPath;  // Empty if the cart was not loaded from a file
+
+    // A cart together with the analysis stored next to its ROM
+    struct LoadedCart {
+        std::shared_ptr<Cart> cart;
+        std::unique_ptr<CodeDataLog> codeDataLog;
+        std::vector<DisasmSegment> disassembly;
+    };
+    // Reads everything from the files, called on the loader thread. saving is waited
+    // for first, the sidecars may still be written.
+    static LoadedCart loadCart(const std::filesystem::path& path, std::shared_future<void> saving);
+    bool swapCart(LoadedCart loaded, const std::filesystem::path& path);
+
+    std::shared_future<void> m_saving;  // Sidecars of the last saveAnalysis
+    std::future<LoadedCart> m_loading;
+    std::filesystem::path m_loadingPath;
+    std::function<void(bool)> m_onLoaded;
+
     std::function<void(unsigned int, unsigned int, unsigned int)> m_setPixel;
 
     std::array<std::shared_ptr<Port>, 2> m_ports;
+    std::array<Input::Controller, 2> m_inputs;  // Read by the ports, sampled once per frame
+    bool m_inputFrame = false;                  // Odd frame flag of the frame m_inputs were sampled for
+    void sampleInputs();
+
+    std::vector<uint32_t> m_frameHashes;
+
+    uint8_t* m_ramBuffer = nullptr;
+    uint8_t* m_frameBuffer = nullptr;
+    bool m_renderSkip = false;
 
     Mode m_mode = Mode::RESET;
 
@@ -112,10 +198,35 @@ private:
     bool m_isInterrupt = false;         // True, when BRK is executed from interrupt
 
     /* DMA */
-    int16_t m_dmaCycle = 0;
+    static int16_t constexpr DMA_REQUESTED = -2;  // OAMDMA was written, the transfer starts after the current instruction
+    static int16_t constexpr DMA_ALIGN = -1;      // Extra cycle when the CPU was halted on an odd cycle
+    static int16_t constexpr DMA_LENGTH = 512;    // Alternating reads and writes. Also the idle state.
+    int16_t m_dmaCycle = DMA_LENGTH;
     uint16_t m_dmaPage = 0;
+    bool m_dmaBulk = false;  // The page was copied at once, the transfer cycles only stall the CPU
     void execDma();
 
+    /* Idle Loops */
+    static unsigned long constexpr IDLE_MAX_PERIOD = 64;  // Longest loop iteration in cycles
+    struct IdleLoop {
+        bool valid = false;
+        uint16_t head = 0;          // Opcode address the iteration starts at
+        uint8_t a = 0, x = 0, y = 0, sp = 0, status = 0;
+        uint8_t ppuStatus = 0;
+        unsigned long cycle = 0;
+        unsigned long sideEffects = 0;
+        unsigned long statusReads = 0;
+        unsigned int quietDots = 0;  // PPU dots without events from the snapshot on
+    };
+    IdleLoop m_idleLoop;
+    unsigned long m_idleCycles = 0;
+    unsigned long m_frameIdleCycles = 0;  // m_idleCycles when the frame started
+    void checkIdleLoop(uint16_t previousAddress);
+
+    /* Profiling */
+    static unsigned int constexpr PPU_SAMPLE_RATE = 64;  // One in this many PPU steps is timed
+    __forceinline void runPpu();
+
     /* Emulator Flow Control */
     bool m_errorInCycle = false;  // Set if error occurs in cycle. Will go into stepping mode.
     bool m_interruptInCycle = false;  // Set if interrupt occurs in cycle. Will go into stepping mode if break on interrupt is set.
@@ -172,6 +283,7 @@ private:
     __forceinline void     _redmAbsY();
     __forceinline void     _redmIndX();
     __forceinline void     _redmIndY();
+    __forceinline void     _writeBack();
     __forceinline void     _storeMem();
 
     template<typename T>
@@ -0,0 +1,44 @@
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+#include "framehash.hpp"
+#include "core/util.hpp"
+
+bool FrameHash::save(const std::filesystem::path& path, const std::vector<uint32_t>& hashes) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        LOG_ERR << "Frame hashes " << path << " could not be opened.\n";
+        return false;
+    }
+
+    out << std::hex << std::setfill('0');
+    for (uint32_t hash : hashes) {
+        out << std::setw(8) << hash << "\n";
+    }
+    return true;
+}
+
+bool FrameHash::load(const std::filesystem::path& path, std::vector<uint32_t>& hashes) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        LOG_ERR << "Frame hashes " << path << " could not be opened.\n";
+        return false;
+    }
+
+    hashes.clear();
+    uint32_t hash;
+    while (in >> std::hex >> hash) {
+        hashes.push_back(hash);
+    }
+    if (!in.eof()) {
+        LOG_ERR << "Frame hashes " << path << " are malformed after frame " << hashes.size() << ".\n";
+        return false;
+    }
+    return true;
+}
+
+size_t FrameHash::firstMismatch(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+    size_t length = std::min(a.size(), b.size());
+    return std::mismatch(a.begin(), a.begin() + length, b.begin()).first - a.begin();
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <filesystem>
+
+// Streams of per-frame state hashes, see Emu::hashState. Stored as text with
+// one hex hash per line, so two runs can be compared with any diff tool.
+namespace FrameHash {
+    bool save(const std::filesystem::path& path, const std::vector<uint32_t>& hashes);
+    bool load(const std::filesystem::path& path, std::vector<uint32_t>& hashes);
+
+    // Index of the first frame that differs, the length of the shorter stream if one is a prefix of the other
+    size_t firstMismatch(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b);
+}
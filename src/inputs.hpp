@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <map>
 #include <vector>
 #include <unordered_set>
@@ -115,6 +116,29 @@ namespace Input {
         bool select = false;
         bool btn_a = false;
         bool btn_b = false;
+
+        // Buttons in the order they are shifted out of the controller, A in bit 0
+        uint8_t toBits() const {
+            return (btn_a   ? 0x01 : 0) | (btn_b  ? 0x02 : 0) | (select ? 0x04 : 0) | (start   ? 0x08 : 0)
+                 | (d_up    ? 0x10 : 0) | (d_down ? 0x20 : 0) | (d_left ? 0x40 : 0) | (d_right ? 0x80 : 0);
+        }
+
+        static Controller fromBits(uint8_t bits) {
+            Controller c;
+            c.btn_a   = bits & 0x01;
+            c.btn_b   = bits & 0x02;
+            c.select  = bits & 0x04;
+            c.start   = bits & 0x08;
+            c.d_up    = bits & 0x10;
+            c.d_down  = bits & 0x20;
+            c.d_left  = bits & 0x40;
+            c.d_right = bits & 0x80;
+            return c;
+        }
+
+        Controller operator|(const Controller& other) const {
+            return fromBits(toBits() | other.toBits());
+        }
     };
 
     struct State {
@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include <miniz.h>
+#include <json.hpp>
+
+#include "library.hpp"
+#include "rom.hpp"
+#include "core/util.hpp"
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+// Entries of older indexes have a CRC over the whole file
+static int constexpr INDEX_VERSION = 2;
+
+static size_t constexpr INES_HEADER_SIZE = 16;
+
+static bool parseHeader(const uint8_t* header, RomEntry& entry) {
+    if (header[0] != 'N' || header[1] != 'E' || header[2] != 'S' || header[3] != 0x1a) {
+        return false;
+    }
+    entry.prgSize = header[4];
+    entry.chrSize = header[5];
+    entry.battery = header[6] & 0x02;
+    entry.mapper = (header[7] & 0xf0) | (header[6] >> 4);
+    return true;
+}
+
+// The CRC is the one of Cart, so entries match movies and analysis files
+static bool indexNes(const fs::path& path, RomEntry& entry) {
+    std::shared_ptr<const RomImage> image = RomImage::fromNes(path);
+    if (!image || !Cart::isValidImage(*image) || !parseHeader(image->data(), entry)) {
+        return false;
+    }
+    entry.name = path.filename().string();
+    entry.crc = Cart::romCrc(*image);
+    return true;
+}
+
+// Uses the first .nes file in the archive, like Cart::fromFile
+static bool indexZip(const fs::path& path, RomEntry& entry) {
+    mz_zip_archive zip;
+    memset(&zip, 0, sizeof(zip));
+    if (!mz_zip_reader_init_file(&zip, path.string().c_str(), 0)) {
+        return false;
+    }
+
+    bool found = false;
+    mz_uint fileCount = mz_zip_reader_get_num_files(&zip);
+    for (mz_uint i = 0; i < fileCount && !found; i++) {
+        mz_zip_archive_file_stat stat;
+        if (!mz_zip_reader_file_stat(&zip, i, &stat) || fs::path(stat.m_filename).extension() != ".nes") {
+            continue;
+        }
+
+        // Only the header is inflated. The checksum in the central directory
+        // includes it, so the CRC is left for RomLibrary::setCrc.
+        uint8_t header[INES_HEADER_SIZE];
+        mz_zip_reader_extract_iter_state* iter = mz_zip_reader_extract_iter_new(&zip, i, 0);
+        if (iter) {
+            found = mz_zip_reader_extract_iter_read(iter, header, INES_HEADER_SIZE) == INES_HEADER_SIZE
+                && parseHeader(header, entry);
+            mz_zip_reader_extract_iter_free(iter);
+        }
+        entry.name = stat.m_filename;
+        break;
+    }
+
+    mz_zip_reader_end(&zip);
+    return found;
+}
+
+RomLibrary::RomLibrary(const fs::path& indexPath) : m_indexPath(indexPath) {
+    std::atomic_store(&m_entries, std::make_shared<const std::vector<RomEntry>>());
+}
+
+RomLibrary::~RomLibrary() {
+    cancel();
+}
+
+void RomLibrary::cancel() {
+    m_cancel = true;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    m_cancel = false;
+}
+
+void RomLibrary::scan(const fs::path& root) {
+    cancel();
+    m_scanning = true;
+    m_thread = std::thread(&RomLibrary::run, this, root);
+}
+
+void RomLibrary::run(fs::path root) {
+    // Previous results by path, reused for files that did not change
+    Entries previous = entries();
+    std::unordered_map<std::string, const RomEntry*> known;
+    for (const RomEntry& entry : *previous) {
+        known[entry.path] = &entry;
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<fs::path> directories = { root };
+    unsigned int busy = 0;  // Workers listing a directory, they might add more
+    std::vector<RomEntry> found;
+
+    auto worker = [&]() {
+        std::vector<RomEntry> local;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            changed.wait(lock, [&]() { return !directories.empty() || busy == 0 || m_cancel; });
+            if (m_cancel || directories.empty()) {
+                break;
+            }
+            fs::path directory = std::move(directories.front());
+            directories.pop_front();
+            busy++;
+            lock.unlock();
+
+            std::vector<fs::path> subdirectories;
+            std::error_code ec;
+            for (fs::directory_iterator it(directory, ec), end; !ec && it != end && !m_cancel; it.increment(ec)) {
+                const fs::path& path = it->path();
+                if (it->is_directory(ec)) {
+                    subdirectories.push_back(path);
+                    continue;
+                }
+
+                bool isZip = path.extension() == ".zip";
+                if (!isZip && path.extension() != ".nes") {
+                    continue;
+                }
+
+                RomEntry entry;
+                entry.path = path.string();
+                entry.fileSize = it->file_size(ec);
+                entry.fileTime = it->last_write_time(ec).time_since_epoch().count();
+
+                auto cached = known.find(entry.path);
+                if (cached != known.end()
+                    && cached->second->fileSize == entry.fileSize
+                    && cached->second->fileTime == entry.fileTime) {
+                    local.push_back(*cached->second);
+                } else if (isZip ? indexZip(path, entry) : indexNes(path, entry)) {
+                    local.push_back(std::move(entry));
+                }
+            }
+
+            lock.lock();
+            busy--;
+            for (fs::path& subdirectory : subdirectories) {
+                directories.push_back(std::move(subdirectory));
+            }
+            changed.notify_all();
+        }
+        found.insert(found.end(), std::make_move_iterator(local.begin()), std::make_move_iterator(local.end()));
+        changed.notify_all();
+    };
+
+    unsigned int workerCount = std::max(2u, std::thread::hardware_concurrency());
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < workerCount; i++) {
+        workers.emplace_back(worker);
+    }
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+
+    if (!m_cancel) {
+        std::sort(found.begin(), found.end(), [](const RomEntry& a, const RomEntry& b) {
+            return a.name != b.name ? a.name < b.name : a.path < b.path;
+        });
+        LOG_MSG << "Indexed " << found.size() << " ROMs in " << root << "\n";
+        std::atomic_store(&m_entries, std::make_shared<const std::vector<RomEntry>>(std::move(found)));
+        save();
+    }
+    m_scanning = false;
+}
+
+void RomLibrary::setCrc(const std::string& path, uint32_t crc) {
+    Entries current = entries();
+    auto entry = std::find_if(current->begin(), current->end(), [&](const RomEntry& e) { return e.path == path; });
+    if (entry == current->end() || entry->crc == crc) {
+        return;
+    }
+
+    auto updated = std::make_shared<std::vector<RomEntry>>(*current);
+    (*updated)[entry - current->begin()].crc = crc;
+    std::atomic_store(&m_entries, Entries(updated));
+
+    // A running scan saves the index when it is done
+    if (!m_scanning) {
+        save();
+    }
+}
+
+bool RomLibrary::load() {
+    std::ifstream in(m_indexPath);
+    if (!in.is_open()) {
+        return false;
+    }
+
+    json j = json::parse(in, nullptr, false);
+    if (j.is_discarded() || !j.contains("entries")) {
+        LOG_ERR << "Could not parse ROM index " << m_indexPath << "\n";
+        return false;
+    }
+    if (j.value("version", 0) != INDEX_VERSION) {
+        return false;
+    }
+
+    auto entries = std::make_shared<std::vector<RomEntry>>();
+    for (const json& e : j["entries"]) {
+        RomEntry entry;
+        entry.path = e.value("path", "");
+        entry.name = e.value("name", "");
+        entry.fileSize = e.value("size", uint64_t(0));
+        entry.fileTime = e.value("time", int64_t(0));
+        entry.crc = e.value("crc", uint32_t(0));
+        entry.mapper = e.value("mapper", uint8_t(0));
+        entry.prgSize = e.value("prg", uint8_t(0));
+        entry.chrSize = e.value("chr", uint8_t(0));
+        entry.battery = e.value("battery", false);
+        entries->push_back(std::move(entry));
+    }
+    std::atomic_store(&m_entries, Entries(entries));
+    return true;
+}
+
+bool RomLibrary::save() const {
+    json list = json::array();
+    for (const RomEntry& entry : *entries()) {
+        list.push_back({
+            { "path", entry.path },
+            { "name", entry.name },
+            { "size", entry.fileSize },
+            { "time", entry.fileTime },
+            { "crc", entry.crc },
+            { "mapper", entry.mapper },
+            { "prg", entry.prgSize },
+            { "chr", entry.chrSize },
+            { "battery", entry.battery },
+        });
+    }
+
+    std::ofstream out(m_indexPath);
+    if (!out.is_open()) {
+        LOG_ERR << "Could not write ROM index " << m_indexPath << "\n";
+        return false;
+    }
+    out << json{ { "version", INDEX_VERSION }, { "entries", list } };
+    return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+
+// Metadata of a ROM file, read from the iNES header
+struct RomEntry {
+    std::string path;
+    std::string name;       // File name, or name of the ROM inside a ZIP archive
+    uint64_t fileSize = 0;  // Size and time of the file when it was indexed
+    int64_t fileTime = 0;
+    uint32_t crc = 0;       // CRC32 of PRG and CHR ROM like Cart::m_crc, 0 for ZIP archives until opened
+    uint8_t mapper = 0;
+    uint8_t prgSize = 0;    // In 16 KB banks
+    uint8_t chrSize = 0;    // In 8 KB banks, 0 for CHR RAM
+    bool battery = false;
+};
+
+// Index of the ROMs below a directory, built on worker threads. Files that
+// did not change since the last scan are taken from the persisted index.
+class RomLibrary {
+public:
+    using Entries = std::shared_ptr<const std::vector<RomEntry>>;
+
+    RomLibrary(const std::filesystem::path& indexPath);
+    ~RomLibrary();
+
+    void scan(const std::filesystem::path& root);
+    void cancel();
+    bool isScanning() const { return m_scanning; }
+
+    // Sorted by name. Only accessed through the std::atomic_* functions for shared_ptr.
+    Entries entries() const { return std::atomic_load(&m_entries); }
+
+    // ZIP archives are indexed from the header alone, their CRC is known once the ROM is loaded
+    void setCrc(const std::string& path, uint32_t crc);
+
+    bool load();
+    bool save() const;
+
+private:
+    std::filesystem::path m_indexPath;
+
+    Entries m_entries;
+
+    std::atomic<bool> m_scanning{ false };
+    std::atomic<bool> m_cancel{ false };
+    std::thread m_thread;
+
+    void run(std::filesystem::path root);
+};
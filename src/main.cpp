@@ -1,20 +1,94 @@
 ﻿#include <cstdlib>
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
+#include <iomanip>
 #include <iostream>
 
 #include "core/util.hpp"
 #include "core/gui/manager.hpp"
+#include "core/profiler.hpp"
+#include "core/tracer.hpp"
 #include "defs.hpp"
 #include "rom.hpp"
 #include "mem.hpp"
 #include "emu.hpp"
 #include "disasm.hpp"
+#include "cdl.hpp"
+#include "framehash.hpp"
+#include "testrunner.hpp"
+#include "control.hpp"
+#include "batch.hpp"
 
 namespace fs = std::filesystem;
 namespace cli = CliArguments;
 
 void printUsage(const char* prog) {
     std::cout << prog << " [--rom <rom_file>] [--fullscreen] [--help]\n";
+    std::cout << prog << " --headless --rom <rom_file> --movie <movie_file> [--hashes <out_file>] [--verify-hashes <hash_file>]\n";
+    std::cout << prog << " --control <name> --rom <rom_file>\n";
+    std::cout << prog << " --test-roms <dir> [--goldens <file>] [--update-goldens] [--frames <max_frames>] [--jobs <threads>]\n";
+    std::cout << prog << " --batch <instances> --rom <rom_file> [--frames <frames>] [--jobs <threads>]\n";
+    std::cout << prog << " --benchmark --rom <rom_file> [--frames <frames>] [--repeat <runs>]\n";
+    std::cout << "Any mode takes [--trace <trace_file>] to record a Chrome trace until it exits.\n";
+}
+
+// Replays a movie without a window at full speed. The frame hashes can be
+// written out or compared against those of an earlier run.
+int runHeadless(const char* romPath, const char* moviePath, const char* hashesPath, const char* verifyPath) {
+    std::vector<uint32_t> expected;
+    if (verifyPath && !FrameHash::load(verifyPath, expected)) {
+        return EXIT_FAILURE;
+    }
+
+    Emu::Config config;
+    config.hashFrames = hashesPath || verifyPath;
+    Emu emu(config);
+    // Battery RAM is not mapped, the player's save file stays as it is
+    std::shared_ptr<Cart> cart = romPath ? Cart::fromFile(romPath, false) : nullptr;
+    if (!cart) {
+        LOG_ERR << "Headless mode needs a valid ROM.\n";
+        return EXIT_FAILURE;
+    }
+    emu.init(cart);
+    if (!moviePath || !emu.m_movie.load(moviePath) || !emu.playMovie()) {
+        LOG_ERR << "Headless mode needs a movie recorded with this ROM.\n";
+        return EXIT_FAILURE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Pixels are only needed for the frame hashes
+    emu.setRenderSkip(!emu.m_hashFrames);
+    emu.m_isStepping = false;
+    size_t frames = 0;
+    while (emu.m_movie.isActive() && !emu.m_isStepping) {
+        emu.stepFrame();
+        frames++;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Replayed " << frames << " frames in " << elapsed.count() << "s ("
+              << frames / elapsed.count() << " fps)\n";
+
+    // The emulator stops on errors, the movie did not play to the end
+    if (emu.m_isStepping) {
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<uint32_t>& hashes = emu.getFrameHashes();
+    if (hashesPath && !FrameHash::save(hashesPath, hashes)) {
+        return EXIT_FAILURE;
+    }
+    if (verifyPath) {
+        size_t mismatch = FrameHash::firstMismatch(hashes, expected);
+        if (mismatch < hashes.size() || hashes.size() != expected.size()) {
+            std::cout << "Frame hashes differ from frame " << mismatch << "\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << "Frame hashes match\n";
+    }
+    return EXIT_SUCCESS;
 }
 
 extern void createDisassembly(Gui::Manager<Emu>& manager);
@@ -25,6 +99,22 @@ extern void createOamViewer(Gui::Manager<Emu>& manager);
 extern void createControls(Gui::Manager<Emu>& manager);
 extern void createRomInfo(Gui::Manager<Emu>& manager);
 extern void createSetupControllers(Gui::Manager<Emu>& manager);
+extern void createRomLibrary(Gui::Manager<Emu>& manager);
+extern void createPerformance(Gui::Manager<Emu>& manager);
+
+static bool tracing = false;
+static const char* traceFile = "trace.json";
+
+static void toggleTrace() {
+    if (tracing) {
+        Tracer::start();
+        Gui::addNotification("Recording trace");
+    } else if (Tracer::stop(traceFile)) {
+        Gui::addNotification(std::string("Trace written to ") + traceFile);
+    } else {
+        Gui::addNotification(std::string("Could not write ") + traceFile);
+    }
+}
 
 void registerGuiElements(Gui::Manager<Emu>& manager) {
     createDisassembly(manager);
@@ -35,6 +125,8 @@ void registerGuiElements(Gui::Manager<Emu>& manager) {
     createControls(manager);
     createRomInfo(manager);
     createSetupControllers(manager);
+    createRomLibrary(manager);
+    createPerformance(manager);
 
     manager.action("File", "Reset", 
                    [](Emu& emu) -> void  { emu.reset(); });
@@ -46,11 +138,152 @@ void registerGuiElements(Gui::Manager<Emu>& manager) {
                    [](Emu& emu) -> bool& { return emu.m_disassembler->m_showAbsoluteLabels; }, 
                    [](Emu& emu) -> void  { emu.m_disassembler->refresh(); }
     );
+    manager.checkbox("Debugger", "Static Analysis",
+                     [](Emu& emu) -> bool& { return emu.m_disassembler->m_staticAnalysis; });
+    manager.checkbox("Debugger", "Code/Data Logger",
+                     [](Emu& emu) -> bool& { return emu.m_cdl->m_enabled; });
+    manager.action("Debugger", "Save Analysis",
+                   [](Emu& emu) -> void  { emu.saveAnalysis(); });
+    manager.checkbox("Debugger", "Skip Idle Loops",
+                     [](Emu& emu) -> bool& { return emu.m_skipIdleLoops; });
+    manager.action("Debugger", "Record Trace",
+                   [](Emu& emu) -> bool& { return tracing; },
+                   [](Emu& emu) -> void  { toggleTrace(); }
+    );
+    manager.checkbox("Debugger", "Frame Hashes",
+                     [](Emu& emu) -> bool& { return emu.m_hashFrames; });
+    manager.action("Debugger", "Save Frame Hashes",
+                   [](Emu& emu) -> void  { FrameHash::save(emu.getSidecarPath(".hashes"), emu.getFrameHashes()); });
+}
+
+// Serves step requests of another process, see ControlServer
+int runControlled(const char* name, const char* romPath) {
+    Emu emu(Emu::Config{});
+    ControlServer server(emu);
+    if (!server.open(name)) {
+        return EXIT_FAILURE;
+    }
+    std::shared_ptr<Cart> cart = romPath ? Cart::fromFile(romPath, false) : nullptr;
+    if (!cart) {
+        LOG_ERR << "Control mode needs a valid ROM.\n";
+        return EXIT_FAILURE;
+    }
+    emu.init(cart);
+
+    server.serve();
+    return EXIT_SUCCESS;
+}
+
+// Steps a batch of instances as a smoke test of BatchEmu. All of them get the
+// same inputs, so they have to end up with the same RAM.
+int runBatch(const char* romPath, size_t count, unsigned int frames, unsigned int jobs) {
+    if (!romPath || count == 0) {
+        LOG_ERR << "Batch mode needs a valid ROM and at least one instance.\n";
+        return EXIT_FAILURE;
+    }
+    BatchEmu batch(romPath, count, 1, 1, jobs);
+    if (!batch.isValid()) {
+        LOG_ERR << "Batch mode could not load the ROM.\n";
+        return EXIT_FAILURE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<uint8_t> inputs(2 * count);
+    for (unsigned int frame = 0; frame < frames; frame++) {
+        // Start is pressed now and then to get past title screens
+        Input::Controller input;
+        input.start = frame % 60 < 5;
+        std::fill(inputs.begin(), inputs.end(), input.toBits());
+        batch.step(inputs.data());
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Stepped " << count << " instances for " << frames << " frames in " << elapsed.count() << "s ("
+              << count * frames / elapsed.count() << " fps)\n";
+
+    for (size_t i = 0; i < count; i++) {
+        if (batch.errors()[i]) {
+            std::cout << "Instance " << i << " stopped on a CPU error\n";
+            return EXIT_FAILURE;
+        }
+        if (!std::equal(batch.ram(), batch.ram() + Memory::INTERNAL_RAM_SIZE, batch.ram() + i * Memory::INTERNAL_RAM_SIZE)) {
+            std::cout << "RAM of instance " << i << " differs from instance 0\n";
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+// Runs a ROM from power on with the same inputs several times and prints the
+// speed of each run and of the fastest one, the least disturbed by the system.
+// Pixels are composed like in the GUI. The final state hash has to be the same
+// for every run, and for builds that should not change emulation.
+int runBenchmark(const char* romPath, unsigned int frames, unsigned int runs) {
+    if (!romPath || frames == 0 || runs == 0) {
+        LOG_ERR << "Benchmark mode needs a valid ROM, frames and runs.\n";
+        return EXIT_FAILURE;
+    }
+
+    double best = 0.0;
+    uint32_t hash = 0;
+    for (unsigned int run = 0; run < runs; run++) {
+        std::shared_ptr<Cart> cart = Cart::fromFile(romPath, false);
+        if (!cart) {
+            LOG_ERR << "Benchmark mode could not load the ROM.\n";
+            return EXIT_FAILURE;
+        }
+        Emu emu(Emu::Config{});
+        emu.init(cart);
+        emu.m_isStepping = false;
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (unsigned int frame = 0; frame < frames && !emu.m_isStepping; frame++) {
+            // Start is pressed now and then to get past title screens, like in batch mode
+            Input::Controller input;
+            input.start = frame % 60 < 5;
+            emu.setFrameInputs(input, Input::Controller());
+            emu.stepFrame();
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        double fps = frames / elapsed.count();
+        best = std::max(best, fps);
+        std::cout << "Run " << run + 1 << ": " << frames << " frames in " << elapsed.count() << "s (" << fps << " fps)\n";
+
+        if (emu.m_isStepping) {
+            std::cout << "Run " << run + 1 << " stopped on a CPU error\n";
+            return EXIT_FAILURE;
+        }
+        if (run > 0 && emu.hashState() != hash) {
+            std::cout << "Run " << run + 1 << " ended in a different state\n";
+            return EXIT_FAILURE;
+        }
+        hash = emu.hashState();
+    }
+
+    std::cout << "Best: " << best << " fps, state hash " << std::hex << std::setw(8) << std::setfill('0') << hash << "\n";
+    return EXIT_SUCCESS;
 }
 
 int main(int ac, char ** av) {
     const char* romPath = cli::value(ac, av, "--rom");
+    const char* moviePath = cli::value(ac, av, "--movie");
+    const char* hashesPath = cli::value(ac, av, "--hashes");
+    const char* verifyPath = cli::value(ac, av, "--verify-hashes");
+    const char* testDir = cli::value(ac, av, "--test-roms");
+    const char* controlName = cli::value(ac, av, "--control");
+    const char* batchCount = cli::value(ac, av, "--batch");
+    const char* goldensPath = cli::value(ac, av, "--goldens");
+    const char* maxFrames = cli::value(ac, av, "--frames");
+    const char* jobs = cli::value(ac, av, "--jobs");
+    const char* tracePath = cli::value(ac, av, "--trace");
+    const char* repeat = cli::value(ac, av, "--repeat");
+    bool updateGoldens = cli::flag(ac, av, "--update-goldens");
     bool fullscreen = cli::flag(ac, av, "--fullscreen");
+    bool headless = cli::flag(ac, av, "--headless");
+    bool benchmark = cli::flag(ac, av, "--benchmark");
     bool help = cli::flag(ac, av, "--help");
 
     if (help) {
@@ -60,6 +293,46 @@ int main(int ac, char ** av) {
 
     Settings::read();
 
+    Tracer::setThreadName("Main");
+    if (tracePath) {
+        traceFile = tracePath;
+        tracing = true;
+        Tracer::start();
+    }
+    // Writes a trace that is still recording on every way out of main
+    struct TraceWriter {
+        ~TraceWriter() {
+            if (Tracer::isEnabled()) {
+                Tracer::stop(traceFile);
+            }
+        }
+    } traceWriter;
+
+    if (headless) {
+        return runHeadless(romPath, moviePath, hashesPath, verifyPath);
+    }
+    if (controlName) {
+        return runControlled(controlName, romPath);
+    }
+    if (batchCount) {
+        return runBatch(romPath,
+                        std::strtoul(batchCount, nullptr, 10),
+                        maxFrames ? std::atoi(maxFrames) : 600,
+                        jobs ? std::atoi(jobs) : 0);
+    }
+    if (benchmark) {
+        return runBenchmark(romPath,
+                            maxFrames ? std::atoi(maxFrames) : 3600,
+                            repeat ? std::atoi(repeat) : 5);
+    }
+    if (testDir) {
+        return TestRunner::runSuite(testDir,
+                                    goldensPath ? fs::path(goldensPath) : fs::path("test-goldens.txt"),
+                                    updateGoldens,
+                                    maxFrames ? std::atoi(maxFrames) : 60 * 60,
+                                    jobs ? std::atoi(jobs) : 0);
+    }
+
     Emu emu;
     if (romPath) {
         emu.init(romPath);
@@ -79,6 +352,9 @@ int main(int ac, char ** av) {
     char buffer[64];
 
     while (!manager.isWindowClosing()) {
+        Profiler::beginFrame();
+        Tracer::Span span("Main Loop", "frame");
+
         double currentTime = glfwGetTime();
         frameCount++;
         if (currentTime - previousTime >= 1.0)
@@ -92,6 +368,9 @@ int main(int ac, char ** av) {
         
         Gui::pollEvents();
 
+        // A cart loaded in the background replaces the current one between frames
+        emu.pollLoad();
+
         if (emu.m_isStepping || !emu.isInitialized()) {
             manager.runUi(emu);
         } else {
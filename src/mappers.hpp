@@ -8,7 +8,7 @@ const char * mappers[0xff] = {
     "MMC5",
     "Game Doctor Mode 1",
 
-    nullptr,
+    "AxROM",
     nullptr,
     nullptr,
     nullptr,
@@ -78,7 +78,7 @@ const char * mappers[0xff] = {
 
     nullptr,
     nullptr,
-    nullptr,
+    "GxROM",
     nullptr,
     nullptr,
     nullptr,
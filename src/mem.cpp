@@ -1,4 +1,5 @@
 #include <iostream>
+#include <cstring>
 
 #include "rom.hpp"
 #include "mem.hpp"
@@ -7,6 +8,7 @@
 #include "emu.hpp"
 #include "core/util.hpp"
 #include "controllers.hpp"
+#include "cdl.hpp"
 
 namespace sm = StreamManipulators;
 
@@ -14,6 +16,14 @@ Memory::Memory(Emu& emu, std::shared_ptr<Cart> cart, std::shared_ptr<PPU> ppu)
     : m_emu(emu), m_cart(cart), m_ppu(ppu)
 {}
 
+void Memory::setRamBuffer(uint8_t* buffer) {
+    buffer = buffer ? buffer : m_ramBuffer;
+    if (buffer != m_internalRam) {
+        memcpy(buffer, m_internalRam, INTERNAL_RAM_SIZE);
+        m_internalRam = buffer;
+    }
+}
+
 void Memory::setPort0(std::shared_ptr<Port> p) { m_port0 = p; }
 void Memory::setPort1(std::shared_ptr<Port> p) { m_port1 = p; }
 
@@ -26,6 +36,11 @@ uint8_t Memory::readb(uint16_t addr) {
     // PPU Registers, mirrored
     else if (addr < 0x4000) {
         uint8_t addr_lo = addr & 0b00000111;
+        if (addr_lo == PPU::PPUSTATUS) {
+            m_statusReads++;
+        } else {
+            m_sideEffects++;
+        }
         return m_ppu->readRegister(addr_lo);
     }
     // OAM DMA
@@ -35,13 +50,16 @@ uint8_t Memory::readb(uint16_t addr) {
     }
     // Gamepad
     else if (addr == 0x4016) {
+        m_sideEffects++;
         return m_port0->read();
     }
     else if (addr == 0x4017) {
+        m_sideEffects++;
         return m_port1->read();
     }
     // APU/IO Registers
     else if (addr < 0x4018) {
+        m_sideEffects++;
         //LOG_ERR << "readb(" 
         //        << sm::hex(addr) 
         //        << ") Access to APU/IO\n";
@@ -56,8 +74,45 @@ uint8_t Memory::readb(uint16_t addr) {
     }
     // Access Cartridge CPU Bus
     else {
+        m_emu.m_cdl->logPrg(addr, CodeDataLog::PRG_DATA);
+        return m_cart->readb_cpu(addr);
+    }
+}
+
+// Read for opcodes and operands, logged as code instead of data
+uint8_t Memory::fetchb(uint16_t addr) {
+    if (isCartSpace(addr)) {
+        m_emu.m_cdl->logPrg(addr, CodeDataLog::PRG_CODE);
         return m_cart->readb_cpu(addr);
     }
+    return readb(addr);
+}
+
+// Read without side effects, used by the debugger
+uint8_t Memory::peekb(uint16_t addr) {
+    if (addr < 0x2000) {
+        return m_internalRam[addr & 0x7ff];
+    } else if (isCartSpace(addr)) {
+        return m_cart->readb_cpu(addr);
+    }
+    return 0;
+}
+
+// Reads a whole page for OAM DMA. Fails for pages where reads have
+// side effects (PPU and I/O registers), those are transferred per cycle.
+bool Memory::readDmaPage(uint8_t page, uint8_t* dest) {
+    uint16_t addr = uint16_t(page) << 8;
+    if (addr < 0x2000) {
+        memcpy(dest, &m_internalRam[addr & 0x7ff], 0x100);
+        return true;
+    } else if (isCartSpace(addr)) {
+        for (unsigned int i = 0; i < 0x100; i++) {
+            m_emu.m_cdl->logPrg(addr | i, CodeDataLog::PRG_DATA);
+            dest[i] = m_cart->readb_cpu(addr | i);
+        }
+        return true;
+    }
+    return false;
 }
 
 bool Memory::isCartSpace(uint16_t addr) {
@@ -65,6 +120,12 @@ bool Memory::isCartSpace(uint16_t addr) {
 }
 
 void Memory::writeb(uint16_t addr, uint8_t value) {
+    writeb(addr, value, m_emu.getCycleCount());
+}
+
+void Memory::writeb(uint16_t addr, uint8_t value, unsigned long cycle) {
+    m_sideEffects++;
+
     if (addr < 0x2000) {
         uint16_t addr_lo = addr & 0x7ff;
         m_internalRam[addr_lo] = value;
@@ -95,6 +156,6 @@ void Memory::writeb(uint16_t addr, uint8_t value) {
     }
     // Access Cartridge CPU Bus
     else {
-        return m_cart->writeb_cpu(addr, value);
+        return m_cart->writeb_cpu(addr, value, cycle);
     }
 }
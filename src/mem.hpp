@@ -15,16 +15,31 @@ class Memory {
 public:
     static bool isCartSpace(uint16_t addr);
 
+    static uint16_t constexpr INTERNAL_RAM_SIZE = 0x800;
+
     Memory(Emu&, std::shared_ptr<Cart>, std::shared_ptr<PPU>);
 
     uint8_t readb(uint16_t addr);
+    uint8_t fetchb(uint16_t addr);
+    uint8_t peekb(uint16_t addr);
     void writeb(uint16_t addr, uint8_t value);
+    void writeb(uint16_t addr, uint8_t value, unsigned long cycle);  // For writes before the current CPU cycle
+    bool readDmaPage(uint8_t page, uint8_t* dest);
+
+    uint8_t* m_internalRam = m_ramBuffer;  // Random on real hardware, cleared so runs are reproducible
 
-    uint8_t m_internalRam[0x800];
+    // Moves the RAM with its contents to memory owned by the caller, e.g. shared
+    // with another process. nullptr moves it back into Memory.
+    void setRamBuffer(uint8_t* buffer);
 
     void setPort0(std::shared_ptr<Port> p);
     void setPort1(std::shared_ptr<Port> p);
 
+    // Writes and reads with side effects or changing results, except PPUSTATUS which is
+    // counted apart. A stretch of code without any behaves the same when run again.
+    unsigned long m_sideEffects = 0;
+    unsigned long m_statusReads = 0;
+
 private:
     Emu& m_emu;
 
@@ -32,6 +47,8 @@ private:
     std::shared_ptr<PPU> m_ppu;
     std::shared_ptr<Port> m_port0;
     std::shared_ptr<Port> m_port1;
+
+    uint8_t m_ramBuffer[INTERNAL_RAM_SIZE] = {};
 };
 
 #endif
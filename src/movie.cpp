@@ -0,0 +1,108 @@
+#include <fstream>
+#include <cstring>
+
+#include "movie.hpp"
+#include "core/util.hpp"
+
+static char constexpr MOVIE_MAGIC[4] = { 'S', 'T', 'M', 0x1a };
+
+void Movie::record(uint32_t romCrc) {
+    m_mode = Mode::Recording;
+    m_romCrc = romCrc;
+    m_position = 0;
+    m_frames.clear();
+}
+
+void Movie::play() {
+    m_mode = m_frames.empty() ? Mode::Off : Mode::Playing;
+    m_position = 0;
+}
+
+void Movie::stop() {
+    m_mode = Mode::Off;
+}
+
+void Movie::frame(std::array<Input::Controller, 2>& inputs) {
+    switch (m_mode) {
+    case Mode::Recording:
+        m_frames.push_back({ inputs[0].toBits(), inputs[1].toBits() });
+        m_position = m_frames.size();
+        break;
+
+    case Mode::Playing:
+        inputs[0] = Input::Controller::fromBits(m_frames[m_position][0]);
+        inputs[1] = Input::Controller::fromBits(m_frames[m_position][1]);
+        if (++m_position == m_frames.size()) {
+            // Stops where the recording stopped, from here on the player has control again
+            m_mode = Mode::Off;
+        }
+        break;
+
+    case Mode::Off:
+        break;
+    }
+}
+
+bool Movie::load(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ifstream::binary);
+    if (!in.is_open()) {
+        LOG_ERR << "Movie " << path << " could not be opened.\n";
+        return false;
+    }
+
+    Header header;
+    if (!in.read((char*)&header, sizeof(Header)) || memcmp(header.magic, MOVIE_MAGIC, sizeof(MOVIE_MAGIC)) != 0) {
+        LOG_ERR << "Movie " << path << " is not a valid movie file.\n";
+        return false;
+    }
+    if (header.version != FORMAT_VERSION || header.start != Start::PowerOn) {
+        LOG_ERR << "Movie " << path << " has unsupported version " << header.version << ".\n";
+        return false;
+    }
+
+    // The count is checked before it sizes anything, a damaged header could ask for gigabytes
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(path, error);
+    if (error || header.frameCount > (size - sizeof(Header)) / sizeof(Frame)) {
+        LOG_ERR << "Movie " << path << " is truncated.\n";
+        return false;
+    }
+
+    std::vector<Frame> frames(header.frameCount);
+    if (!in.read((char*)frames.data(), frames.size() * sizeof(Frame))) {
+        LOG_ERR << "Movie " << path << " is truncated.\n";
+        return false;
+    }
+
+    m_mode = Mode::Off;
+    m_romCrc = header.romCrc;
+    m_position = 0;
+    m_frames = std::move(frames);
+
+    LOG_MSG << "Loaded movie " << path << " with " << m_frames.size() << " frames\n";
+    return true;
+}
+
+bool Movie::save(const std::filesystem::path& path) const {
+    if (m_frames.empty()) {
+        return false;
+    }
+
+    std::ofstream out(path, std::ofstream::binary);
+    if (!out.is_open()) {
+        LOG_ERR << "Movie " << path << " could not be opened.\n";
+        return false;
+    }
+
+    Header header;
+    memcpy(header.magic, MOVIE_MAGIC, sizeof(MOVIE_MAGIC));
+    header.version = FORMAT_VERSION;
+    header.start = Start::PowerOn;
+    header.romCrc = m_romCrc;
+    header.frameCount = uint32_t(m_frames.size());
+
+    out.write((const char*)&header, sizeof(Header));
+    out.write((const char*)m_frames.data(), m_frames.size() * sizeof(Frame));
+    out.close();
+    return true;
+}
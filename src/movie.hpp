@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <filesystem>
+
+#include "inputs.hpp"
+
+// Input movie, the buttons of both controllers for every frame since power on.
+// Replaying it against the same ROM reproduces the recorded session exactly.
+//
+// File layout (little endian): a 16 byte header followed by frameCount pairs
+// of controller bitmasks in the order of Input::Controller::toBits.
+class Movie {
+public:
+    static uint16_t constexpr FORMAT_VERSION = 1;
+
+    enum class Mode {
+        Off,
+        Recording,
+        Playing,
+    };
+
+    // Machine state the first frame starts from
+    enum class Start : uint16_t {
+        PowerOn = 0,
+    };
+
+    struct Header {
+        char magic[4];        // "STM\x1a"
+        uint16_t version;
+        Start start;
+        uint32_t romCrc;      // Cart::m_crc of the recorded ROM
+        uint32_t frameCount;
+    };
+    static_assert(sizeof(Header) == 16, "Movie header must be 16 bytes");
+
+    using Frame = std::array<uint8_t, 2>;
+
+    Mode mode() const { return m_mode; }
+    bool isActive() const { return m_mode != Mode::Off; }
+
+    uint32_t romCrc() const { return m_romCrc; }
+    size_t frameCount() const { return m_frames.size(); }
+    size_t position() const { return m_position; }
+
+    void record(uint32_t romCrc);
+    void play();
+    void stop();
+
+    // Called once per frame: stores the inputs while recording, replaces them while playing.
+    // Playback stops by itself when the last frame has started.
+    void frame(std::array<Input::Controller, 2>& inputs);
+
+    bool load(const std::filesystem::path& path);
+    bool save(const std::filesystem::path& path) const;
+
+private:
+    Mode m_mode = Mode::Off;
+    uint32_t m_romCrc = 0;
+    size_t m_position = 0;
+    std::vector<Frame> m_frames;
+};
@@ -3,48 +3,105 @@
 #include "inputs.hpp"
 #include "emu.hpp"
 #include "core/gui/manager.hpp"
+#include "core/gui/notifications.hpp"
 
-static Input::Controller input0;
-static Input::Controller input1;
+static void renderMovie(Emu& emu) {
+    Movie& movie = emu.m_movie;
+    std::filesystem::path moviePath = emu.getSidecarPath(".stm");
+    switch (movie.mode()) {
+    case Movie::Mode::Recording:
+        ImGui::Text("Recording, frame %zu", movie.position());
+        break;
+    case Movie::Mode::Playing:
+        ImGui::Text("Playing, frame %zu of %zu", movie.position(), movie.frameCount());
+        break;
+    case Movie::Mode::Off:
+        ImGui::Text("%zu frames", movie.frameCount());
+        break;
+    }
+
+    if (!emu.isInitialized()) {
+        return;
+    }
+
+    if (movie.isActive()) {
+        if (ImGui::Button("Stop")) {
+            movie.stop();
+        }
+    } else {
+        if (ImGui::Button("Record")) {
+            emu.recordMovie();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Play")) {
+            if (!emu.playMovie()) {
+                Gui::addNotification("Movie does not match this ROM");
+            }
+        }
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Save")) {
+        if (movie.save(moviePath)) {
+            Gui::addNotification("Saved movie " + moviePath.filename().string());
+        }
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Load")) {
+        if (!movie.isActive() && movie.load(moviePath)) {
+            Gui::addNotification("Loaded movie " + moviePath.filename().string());
+        }
+    }
+}
 
 static void render(Gui::Manager<Emu>::Window& window, Emu& emu) {
     if (*window.show()) {
         if (ImGui::Begin("Controls", window.show())) {
+            // Both controllers use the same labels
+            ImGui::PushID(0);
             ImGui::Text("Controller 1");
-            ImGui::Checkbox("Up", &(input0.d_up));
+            ImGui::Checkbox("Up", &(emu.m_manualInputs[0].d_up));
             ImGui::SameLine();
-            ImGui::Checkbox("Left", &(input0.d_left));
+            ImGui::Checkbox("Left", &(emu.m_manualInputs[0].d_left));
             ImGui::SameLine();
-            ImGui::Checkbox("A", &(input0.btn_a));
+            ImGui::Checkbox("A", &(emu.m_manualInputs[0].btn_a));
             ImGui::SameLine();
-            ImGui::Checkbox("Start", &(input0.start));
+            ImGui::Checkbox("Start", &(emu.m_manualInputs[0].start));
 
-            ImGui::Checkbox("Down", &(input0.d_down));
+            ImGui::Checkbox("Down", &(emu.m_manualInputs[0].d_down));
             ImGui::SameLine();
-            ImGui::Checkbox("Right", &(input0.d_right));
+            ImGui::Checkbox("Right", &(emu.m_manualInputs[0].d_right));
             ImGui::SameLine();
-            ImGui::Checkbox("B", &(input0.btn_b));
+            ImGui::Checkbox("B", &(emu.m_manualInputs[0].btn_b));
             ImGui::SameLine();
-            ImGui::Checkbox("Select", &(input0.select));
+            ImGui::Checkbox("Select", &(emu.m_manualInputs[0].select));
+            ImGui::PopID();
 
             ImGui::Separator();
 
+            ImGui::PushID(1);
             ImGui::Text("Controller 2");
-            ImGui::Checkbox("Up", &(input1.d_up));
+            ImGui::Checkbox("Up", &(emu.m_manualInputs[1].d_up));
             ImGui::SameLine();
-            ImGui::Checkbox("Left", &(input1.d_left));
+            ImGui::Checkbox("Left", &(emu.m_manualInputs[1].d_left));
             ImGui::SameLine();
-            ImGui::Checkbox("A", &(input1.btn_a));
+            ImGui::Checkbox("A", &(emu.m_manualInputs[1].btn_a));
             ImGui::SameLine();
-            ImGui::Checkbox("Start", &(input1.start));
+            ImGui::Checkbox("Start", &(emu.m_manualInputs[1].start));
 
-            ImGui::Checkbox("Down", &(input1.d_down));
+            ImGui::Checkbox("Down", &(emu.m_manualInputs[1].d_down));
             ImGui::SameLine();
-            ImGui::Checkbox("Right", &(input1.d_right));
+            ImGui::Checkbox("Right", &(emu.m_manualInputs[1].d_right));
             ImGui::SameLine();
-            ImGui::Checkbox("B", &(input1.btn_b));
+            ImGui::Checkbox("B", &(emu.m_manualInputs[1].btn_b));
             ImGui::SameLine();
-            ImGui::Checkbox("Select", &(input1.select));
+            ImGui::Checkbox("Select", &(emu.m_manualInputs[1].select));
+            ImGui::PopID();
+
+            ImGui::Separator();
+
+            ImGui::Text("Movie");
+            renderMovie(emu);
         }
         ImGui::End();
     }
@@ -1,44 +1,86 @@
 #include <imgui.h>
+#include <vector>
+#include <algorithm>
 
 #include "core/gui/gui.hpp"
 #include "core/gui/manager.hpp"
 #include "disasm.hpp"
 #include "emu.hpp"
 
-static void render(Gui::Manager<Emu>::Window& window, Emu& emu) {
-    using DisasmSegmentSptr = std::shared_ptr<DisasmSegment>;
+// Index of the first row of each segment. Every segment takes one row per
+// line plus one for its continue button. Rebuilt when the disassembly changes.
+static std::vector<size_t> segmentRows;
+static size_t rowCount = 0;
+static uint32_t rowsRevision = 0;
+
+static void updateRows(Disassembler& disassembler) {
+    if (rowsRevision == disassembler.getRevision()) {
+        return;
+    }
+
+    segmentRows.clear();
+    rowCount = 0;
+    for (auto& segment : disassembler) {
+        segmentRows.push_back(rowCount);
+        rowCount += segment.m_lines.size() + 1;
+    }
+    rowsRevision = disassembler.getRevision();
+}
+
+// Returns true if the disassembly was modified
+static bool renderRow(Gui::Manager<Emu>::Window& window, Emu& emu, size_t row, DisasmKey key) {
+    size_t index = std::upper_bound(segmentRows.begin(), segmentRows.end(), row) - segmentRows.begin() - 1;
+    const DisasmSegment& segment = *(emu.m_disassembler->begin() + index);
+    size_t lineIndex = row - segmentRows[index];
+
+    if (lineIndex == segment.m_lines.size()) {
+        ImGui::PushID(int(segment.m_key));
+        bool pressed = ImGui::SmallButton("continue...");
+        ImGui::PopID();
+        if (pressed) {
+            emu.m_disassembler->continueSegment(segment);
+            return true;
+        }
+        return false;
+    }
 
+    auto& line = segment.m_lines[lineIndex];
+    bool isBreakpoint = emu.isBreakpoint(line.offset);
+    ImGui::PushID(int(line.key));
+    if (ImGui::Selectable(isBreakpoint ? ">###brk" : " ###brk", isBreakpoint)) {
+        emu.toggleBreakpoint(line.offset);
+    }
+    ImGui::PopID();
+    ImGui::SameLine();
+    if (line.key == key) {
+        window.manager.pushHighlightText();
+        ImGui::TextUnformatted(emu.m_disassembler->getText(line));
+        ImGui::PopStyleColor();
+    }
+    else {
+        ImGui::TextUnformatted(emu.m_disassembler->getText(line));
+    }
+    return false;
+}
+
+static void render(Gui::Manager<Emu>::Window& window, Emu& emu) {
     if (emu.getMode() != Emu::Mode::RESET && *window.show()) {
         uint16_t address = emu.getOpcodeAddress();
+        emu.m_disassembler->pollAnalysis();
         emu.m_disassembler->disasmSegment(address);
+        DisasmKey key = emu.m_disassembler->toKey(address);
 
         if (ImGui::Begin("Disassembly", window.show())) {
             window.manager.pushMonoFont();
-            for (auto& segment : *emu.m_disassembler) {
-                for (auto& entry : segment.second->m_lines) {
-                    auto& line = entry.second;
-
-                    bool isBreakpoint = emu.isBreakpoint(line.offset);
-                    static char buffer[0xff];
-                    snprintf(buffer, 0xff, "%s###%04x_brk", isBreakpoint ? ">" : " ", line.offset);
-                    if (ImGui::Selectable(buffer, isBreakpoint)) {
-                        emu.toggleBreakpoint(line.offset);
-                    }
-                    ImGui::SameLine();
-                    if (line.offset == address) {
-                        window.manager.pushHighlightText();
-                        ImGui::Text(line.repr.c_str());
-                        ImGui::PopStyleColor();
-                    }
-                    else {
-                        ImGui::Text(line.repr.c_str());
-                    }
-                }
-                if (ImGui::Button("continue...")) {
-                    emu.m_disassembler->continueSegment(segment.second);
-                    break;
+            updateRows(*emu.m_disassembler);
+
+            // Only the visible rows are looked up and formatted
+            bool modified = false;
+            ImGuiListClipper clipper((int)rowCount);
+            while (clipper.Step()) {
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd && !modified; row++) {
+                    modified = renderRow(window, emu, row, key);
                 }
-                ImGui::Separator();
             }
             ImGui::PopFont();
 
@@ -0,0 +1,126 @@
+#include <imgui.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#include "emu.hpp"
+#include "library.hpp"
+#include "rom.hpp"
+#include "nes/mappers/mapper.hpp"
+#include "core/gui/manager.hpp"
+
+static std::unique_ptr<RomLibrary> library;
+
+static char directory[0x100];
+static char filter[0x40];
+static bool supportedOnly = false;
+static int selectedRow = -1;
+static std::string pendingCrc;  // Opened entry that is indexed without a CRC
+
+// Indices of the entries passing the filter, updated when the entries or the filter change
+static RomLibrary::Entries filteredEntries;
+static std::vector<unsigned int> rows;
+static bool filterChanged = true;
+
+static bool containsNoCase(const std::string& text, const char* pattern) {
+    auto it = std::search(text.begin(), text.end(), pattern, pattern + strlen(pattern),
+        [](char a, char b) { return tolower((unsigned char)a) == tolower((unsigned char)b); });
+    return it != text.end();
+}
+
+static void updateRows(const RomLibrary::Entries& entries) {
+    if (!filterChanged && entries == filteredEntries) {
+        return;
+    }
+    filteredEntries = entries;
+    filterChanged = false;
+    selectedRow = -1;
+
+    rows.clear();
+    for (unsigned int i = 0; i < entries->size(); i++) {
+        const RomEntry& entry = (*entries)[i];
+        if ((!supportedOnly || Mapper::isSupported(entry.mapper)) && containsNoCase(entry.name, filter)) {
+            rows.push_back(i);
+        }
+    }
+}
+
+static void init(Gui::Manager<Emu>::Window& window, Emu& emu) {
+    std::string path = Settings::get("library/directory", Settings::get("rom-directory", std::string()));
+    strncpy(directory, path.c_str(), sizeof(directory) - 1);
+
+    // The stored index is shown right away, the rescan only picks up changes
+    library = std::make_unique<RomLibrary>("library.json");
+    library->load();
+    if (*window.show() && directory[0]) {
+        library->scan(directory);
+    }
+}
+
+static void teardown(Gui::Manager<Emu>::Window& window, Emu& emu) {
+    Settings::set("library/directory", std::string(directory));
+    library.reset();
+}
+
+static void render(Gui::Manager<Emu>::Window& window, Emu& emu) {
+    if (*window.show()) {
+        if (ImGui::Begin("ROM Library", window.show())) {
+            ImGui::InputText("##Directory", directory, sizeof(directory));
+            ImGui::SameLine();
+            if (library->isScanning()) {
+                if (ImGui::Button("Cancel")) {
+                    library->cancel();
+                }
+            } else if (ImGui::Button("Scan")) {
+                library->scan(directory);
+            }
+
+            filterChanged |= ImGui::InputText("Filter", filter, sizeof(filter));
+            ImGui::SameLine();
+            filterChanged |= ImGui::Checkbox("Supported only", &supportedOnly);
+
+            // The CRC of a ZIP archive's ROM is taken from the cart once it is loaded
+            if (!pendingCrc.empty() && !emu.isLoading()) {
+                if (emu.isInitialized() && emu.getRomPath() == pendingCrc) {
+                    library->setCrc(pendingCrc, emu.m_cart->m_crc);
+                }
+                pendingCrc.clear();
+            }
+
+            RomLibrary::Entries entries = library->entries();
+            updateRows(entries);
+            ImGui::Text("%d of %d ROMs%s", (int)rows.size(), (int)entries->size(), library->isScanning() ? ", scanning..." : "");
+            ImGui::Separator();
+
+            window.manager.pushMonoFont();
+            ImGui::BeginChild("##Roms");
+            char text[0x100];
+            ImGuiListClipper clipper((int)rows.size());
+            while (clipper.Step()) {
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                    const RomEntry& entry = (*entries)[rows[row]];
+                    snprintf(text, sizeof(text), "%-48.48s %3d %3d %3d %08X##%d",
+                             entry.name.c_str(), entry.mapper, entry.prgSize, entry.chrSize, entry.crc, row);
+                    if (ImGui::Selectable(text, selectedRow == row, ImGuiSelectableFlags_AllowDoubleClick)) {
+                        selectedRow = row;
+                        if (ImGui::IsMouseDoubleClicked(0)) {
+                            if (window.manager.openFile(emu, entry.path) && entry.crc == 0) {
+                                pendingCrc = entry.path;
+                            }
+                        }
+                    }
+                    if (ImGui::IsItemHovered()) {
+                        ImGui::SetTooltip("%s", entry.path.c_str());
+                    }
+                }
+            }
+            ImGui::EndChild();
+            ImGui::PopFont();
+        }
+        ImGui::End();
+    }
+}
+
+void createRomLibrary(Gui::Manager<Emu>& manager) {
+    manager.window("view-library", "ROM Library", render, init, teardown);
+}
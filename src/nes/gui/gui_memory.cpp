@@ -18,6 +18,7 @@ static void render(Gui::Manager<Emu>::Window& window, Emu& emu) {
             if (ImGui::BeginTabBar("Memory Tabbar", tab_bar_flags)) {
                 if (ImGui::BeginTabItem("RAM")) {
                     window.manager.pushMonoFont();
+                    mem_edit.ReadOnly = false;
                     mem_edit.DrawContents(emu.m_mem->m_internalRam, 0x800, 0x0000);
                     ImGui::PopFont();
                     ImGui::EndTabItem();
@@ -26,7 +27,9 @@ static void render(Gui::Manager<Emu>::Window& window, Emu& emu) {
                     snprintf(title, 10, "PRG %d", i);
                     if (ImGui::BeginTabItem(title)) {
                         window.manager.pushMonoFont();
-                        mem_edit.DrawContents(emu.m_cart->m_prgBanks[i], 0x4000, 0x8000 + 0x4000 * i);  // TODO only true for NROM
+                        // ROM is shared between carts and mapped read-only
+                        mem_edit.ReadOnly = true;
+                        mem_edit.DrawContents((void*)emu.m_cart->m_prgBanks[i], 0x4000, 0x8000 + 0x4000 * i);  // TODO only true for NROM
                         ImGui::PopFont();
                         ImGui::EndTabItem();
                     }
@@ -36,6 +39,7 @@ static void render(Gui::Manager<Emu>::Window& window, Emu& emu) {
                     snprintf(title, 10, "CHR %d", i);
                     if (ImGui::BeginTabItem(title)) {
                         window.manager.pushMonoFont();
+                        mem_edit.ReadOnly = !emu.m_cart->m_useChrRam;
                         mem_edit.DrawContents(emu.m_cart->chr(i), 0x2000, 0x2000 * i);
                         ImGui::PopFont();
                         ImGui::EndTabItem();
@@ -1,4 +1,5 @@
 #include <imgui.h>
+#include <cstring>
 
 #include "emu.hpp"
 #include "ppu.hpp"
@@ -7,14 +8,22 @@
 static int selectedIndex = -1;
 static int selectedOamEntry = -1;
 
-static void renderOamEntry(unsigned int index, const PPU::OamEntry& entry) {
-    if (entry.y >= 0xef) {
-        return;
+// Formatted entries, only updated when the entry changes
+static PPU::OamEntry cachedEntries[64];
+static char cachedText[64][32];
+static bool cached[64] = {};
+
+static const char* getEntryText(unsigned int index, const PPU::OamEntry& entry) {
+    if (!cached[index] || memcmp(cachedEntries[index].fields, entry.fields, sizeof(entry.fields))) {
+        cachedEntries[index] = entry;
+        cached[index] = true;
+        snprintf(cachedText[index], sizeof(cachedText[index]), "%02X  Y: %02X  X: %02X  I: %02X", index, entry.y, entry.x, entry.tileIndex);
     }
+    return cachedText[index];
+}
 
-    char buffer[64];
-    snprintf(buffer, 64, "%02X  Y: %02X  X: %02X  I: %02X", index, entry.y, entry.x, entry.tileIndex);
-    if (ImGui::Selectable(buffer, selectedIndex == index)) {
+static void renderOamEntry(unsigned int index, const PPU::OamEntry& entry) {
+    if (ImGui::Selectable(getEntryText(index, entry), selectedIndex == index)) {
         if (selectedIndex != index) {
             selectedIndex = index;
         } else {
@@ -28,8 +37,21 @@ static void render(Gui::Manager<Emu>::Window& window, Emu& emu) {
     if (emu.isInitialized() && *window.show()) {
         if (ImGui::Begin("OAM Viewer", window.show())) {
             const PPU::OamEntry* entries = emu.m_ppu->getSprites();
+
+            // Entries below the screen are hidden
+            int visible[64];
+            int visibleCount = 0;
             for (int i = 0; i < 64; i++) {
-                renderOamEntry(i, entries[i]);
+                if (entries[i].y < 0xef) {
+                    visible[visibleCount++] = i;
+                }
+            }
+
+            ImGuiListClipper clipper(visibleCount);
+            while (clipper.Step()) {
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                    renderOamEntry(visible[row], entries[visible[row]]);
+                }
             }
         }
         ImGui::End();
@@ -38,4 +60,4 @@ static void render(Gui::Manager<Emu>::Window& window, Emu& emu) {
 
 void createOamViewer(Gui::Manager<Emu>& manager) {
     manager.window("debugger-view-oam", "OAM Viewer", render);
-}
\ No newline at end of file
+}
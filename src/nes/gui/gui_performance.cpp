@@ -0,0 +1,75 @@
+#include <imgui.h>
+
+#include "emu.hpp"
+#include "core/profiler.hpp"
+#include "core/gui/manager.hpp"
+
+using Profiler::Stage;
+
+static float constexpr FRAME_BUDGET_MS = 1000.0f / 60.0f;
+
+static std::vector<Profiler::Frame> frames;
+
+static void init(Gui::Manager<Emu>::Window& window, Emu& emu) {
+    Profiler::setEnabled(*window.show());
+}
+
+static void renderRow(const char* name, const Profiler::Summary& s) {
+    ImGui::Text("%-10s %7.2f %7.2f %7.2f %7.2f %7.2f", name, s.average, s.p50, s.p95, s.p99, s.max);
+}
+
+static void renderFrames(Gui::Manager<Emu>::Window& window) {
+    auto frameTime = [](void*, int i) { return frames[i][Stage::Frame]; };
+    int overBudget = 0;
+    for (const Profiler::Frame& frame : frames) {
+        overBudget += frame[Stage::Frame] > FRAME_BUDGET_MS;
+    }
+
+    char overlay[0x40];
+    snprintf(overlay, sizeof(overlay), "%.2f ms", frames.back()[Stage::Frame]);
+    ImGui::PlotLines("##FrameTimes", frameTime, nullptr, (int)frames.size(), 0, overlay,
+                     0.0f, 2 * FRAME_BUDGET_MS, ImVec2(ImGui::GetContentRegionAvail().x, 80));
+    ImGui::Text("%d of %d frames over the %.1f ms budget", overBudget, (int)frames.size(), FRAME_BUDGET_MS);
+    ImGui::Separator();
+
+    // The CPU is everything in the emulation that is not the PPU
+    std::vector<float> cpu;
+    for (const Profiler::Frame& frame : frames) {
+        cpu.push_back(std::max(0.0f, frame[Stage::Emulation] - frame[Stage::Ppu]));
+    }
+
+    window.manager.pushMonoFont();
+    ImGui::Text("%-10s %7s %7s %7s %7s %7s", "ms", "avg", "p50", "p95", "p99", "max");
+    for (size_t i = 0; i < Profiler::STAGE_COUNT; i++) {
+        Stage stage = Stage(i);
+        renderRow(Profiler::STAGE_NAMES[i], Profiler::summarize(frames, stage));
+        if (stage == Stage::Emulation) {
+            renderRow("  CPU", Profiler::summarize(std::move(cpu)));
+        } else if (stage == Stage::Ppu) {
+            ImGui::SameLine();
+            ImGui::TextDisabled("(sampled)");
+        }
+    }
+    ImGui::PopFont();
+}
+
+static void render(Gui::Manager<Emu>::Window& window, Emu& emu) {
+    // Frames are only recorded while the window is open
+    Profiler::setEnabled(*window.show());
+
+    if (*window.show()) {
+        if (ImGui::Begin("Performance", window.show())) {
+            Profiler::getHistory(frames);
+            if (frames.empty()) {
+                ImGui::Text("No frames recorded yet");
+            } else {
+                renderFrames(window);
+            }
+        }
+        ImGui::End();
+    }
+}
+
+void createPerformance(Gui::Manager<Emu>& manager) {
+    manager.window("view-performance", "Performance", render, init);
+}
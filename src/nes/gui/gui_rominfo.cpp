@@ -12,6 +12,13 @@ static void render(Gui::Manager<Emu>::Window& window, Emu& emu) {
             ImGui::Text("Mapper: %d, %s", emu.m_cart->m_mapperId, mappers[emu.m_cart->m_mapperId]);
             ImGui::Text("PRG ROM #: %d", emu.m_cart->prgSize());
             ImGui::Text(emu.m_cart->m_useChrRam ? "CHR RAM #: %d" : "CHR ROM #: %d", emu.m_cart->chrSize());
+            if (emu.m_cart->hasBattery()) {
+                if (emu.m_cart->isSaveMapped()) {
+                    ImGui::Text("Battery RAM: saved");
+                } else {
+                    ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Battery RAM: not saved");
+                }
+            }
         }
         ImGui::End();
     }
@@ -0,0 +1,91 @@
+#include "core/util.hpp"
+#include "core/probes.hpp"
+#include "rom.hpp"
+#include "nes/mappers/bankedmapper.hpp"
+
+namespace sm = StreamManipulators;
+
+BankedMapper::BankedMapper(Cart& cart) : Mapper(cart) {
+    m_prgPageCount = unsigned(cart.prgSize()) * (PRG_BANK_SIZE / PRG_PAGE_SIZE);
+    m_chrPageCount = unsigned(cart.chrSize()) * (CHR_BANK_SIZE / CHR_PAGE_SIZE);
+
+    // Until the mapper sets up its banks: the first 16 KB and the last 16 KB, 8 KB CHR
+    mapPrg(0, 2, 0);
+    mapPrg(2, 2, -1);
+    mapChr(0, 8, 0);
+}
+
+void BankedMapper::mapPrg(unsigned int page, unsigned int pageCount, int bank) {
+    int bankCount = int(m_prgPageCount / pageCount);
+    bank = ((bank % bankCount) + bankCount) % bankCount;
+
+    unsigned int pagesPerBank = PRG_BANK_SIZE / PRG_PAGE_SIZE;
+    for (unsigned int i = 0; i < pageCount; i++) {
+        unsigned int pageBank = unsigned(bank) * pageCount + i;
+        if (m_prgPageBanks[page + i] != pageBank) {
+            STA_PROBE2(prg__bank, page + i, pageBank);
+        }
+        m_prgPageBanks[page + i] = pageBank;
+        m_prgPages[page + i] = &m_cart.prg(pageBank / pagesPerBank)[(pageBank % pagesPerBank) * PRG_PAGE_SIZE];
+    }
+}
+
+void BankedMapper::mapChr(unsigned int page, unsigned int pageCount, int bank) {
+    int bankCount = int(m_chrPageCount / pageCount);
+    bank = ((bank % bankCount) + bankCount) % bankCount;
+
+    unsigned int pagesPerBank = CHR_BANK_SIZE / CHR_PAGE_SIZE;
+    for (unsigned int i = 0; i < pageCount; i++) {
+        unsigned int pageBank = unsigned(bank) * pageCount + i;
+        if (m_chrPageBanks[page + i] != pageBank) {
+            STA_PROBE2(chr__bank, page + i, pageBank);
+        }
+        m_chrPageBanks[page + i] = pageBank;
+        m_chrPages[page + i] = &m_cart.chr(pageBank / pagesPerBank)[(pageBank % pagesPerBank) * CHR_PAGE_SIZE];
+    }
+}
+
+uint8_t BankedMapper::readbCpu(uint16_t address) {
+    if (address >= 0x8000) {
+        return readPrg(address);
+    } else if (address >= 0x6000 && m_prgRamEnable) {
+        return m_cart.prgRam()[address & 0x1fff];
+    }
+    // Unmapped
+    return 0;
+}
+
+void BankedMapper::writebCpu(uint16_t address, uint8_t value) {
+    if (address >= 0x8000) {
+        writeRegister(address, value);
+    } else if (address >= 0x6000 && m_prgRamEnable && !m_prgRamWriteProtect) {
+        m_cart.prgRam()[address & 0x1fff] = value;
+    }
+}
+
+void BankedMapper::translateCpu(uint16_t addressIn, uint8_t& bankOut, uint16_t& addressOut) {
+    unsigned int bank = m_prgPageBanks[(addressIn >> 13) & 0x03];
+    unsigned int pagesPerBank = PRG_BANK_SIZE / PRG_PAGE_SIZE;
+    bankOut = uint8_t(bank / pagesPerBank);
+    addressOut = uint16_t((bank % pagesPerBank) * PRG_PAGE_SIZE + (addressIn & 0x1fff));
+}
+
+uint8_t BankedMapper::readbPpu(uint16_t address) {
+    return readChr(address);
+}
+
+void BankedMapper::writebPpu(uint16_t address, uint8_t value) {
+    if (m_cart.m_useChrRam) {
+        m_chrPages[(address >> 10) & 0x07][address & 0x3ff] = value;
+    }
+    else {
+        LOG_ERR << "Illegal write to CHR ROM @ " << sm::hex(address) << "\n";
+    }
+}
+
+void BankedMapper::translatePpu(uint16_t addressIn, uint8_t& bankOut, uint16_t& addressOut) {
+    unsigned int bank = m_chrPageBanks[(addressIn >> 10) & 0x07];
+    unsigned int pagesPerBank = CHR_BANK_SIZE / CHR_PAGE_SIZE;
+    bankOut = uint8_t(bank / pagesPerBank);
+    addressOut = uint16_t((bank % pagesPerBank) * CHR_PAGE_SIZE + (addressIn & 0x3ff));
+}
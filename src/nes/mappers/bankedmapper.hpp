@@ -0,0 +1,56 @@
+#pragma once
+
+#include "mapper.hpp"
+
+class Cart;
+
+// Base for mappers that switch PRG ROM in 8 KB pages and CHR in 1 KB pages.
+// A bank switch reassigns page pointers, reads are a table lookup. Also
+// handles PRG RAM at $6000, writes to $8000-$FFFF go to writeRegister.
+class BankedMapper : public Mapper {
+public:
+    BankedMapper(Cart& cart);
+
+    virtual uint8_t readbCpu(uint16_t address) final;
+    virtual void writebCpu(uint16_t address, uint8_t value) final;
+    virtual void translateCpu(uint16_t addressIn, uint8_t& bankOut, uint16_t& addressOut) final;
+
+    virtual uint8_t readbPpu(uint16_t address) final;
+    virtual void writebPpu(uint16_t address, uint8_t value) final;
+    virtual void translatePpu(uint16_t addressIn, uint8_t& bankOut, uint16_t& addressOut) final;
+
+    // Plain lookups, Cart reads ROM through these without a virtual call
+    uint8_t readPrg(uint16_t address) const { return m_prgPages[(address >> 13) & 0x03][address & 0x1fff]; }
+    uint8_t readChr(uint16_t address) const { return m_chrPages[(address >> 10) & 0x07][address & 0x3ff]; }
+
+    // Offsets into PRG and CHR ROM, what translateCpu and translatePpu give as bank and address
+    size_t prgOffset(uint16_t address) const { return size_t(m_prgPageBanks[(address >> 13) & 0x03]) * PRG_PAGE_SIZE + (address & 0x1fff); }
+    size_t chrOffset(uint16_t address) const { return size_t(m_chrPageBanks[(address >> 10) & 0x07]) * CHR_PAGE_SIZE + (address & 0x3ff); }
+
+protected:
+    static uint16_t constexpr PRG_PAGE_SIZE = 0x2000;
+    static uint16_t constexpr CHR_PAGE_SIZE = 0x0400;
+
+    virtual void writeRegister(uint16_t address, uint8_t value) = 0;
+
+    // Maps a bank of pageCount pages to the pages starting at page. Banks are
+    // counted in units of their own size, negative banks count from the end
+    // and out of range banks wrap around like unconnected address lines.
+    void mapPrg(unsigned int page, unsigned int pageCount, int bank);
+    void mapChr(unsigned int page, unsigned int pageCount, int bank);
+
+    // Value seen by the mapper when the ROM drives the data bus at the same time
+    uint8_t busConflict(uint16_t address, uint8_t value) const { return value & readPrg(address); }
+
+    bool m_prgRamEnable = true;
+    bool m_prgRamWriteProtect = false;
+
+private:
+    const uint8_t* m_prgPages[4];  // $8000, $A000, $C000, $E000
+    uint8_t* m_chrPages[8];  // $0000-$1FFF
+    unsigned int m_prgPageBanks[4] = {};
+    unsigned int m_chrPageBanks[8] = {};
+
+    unsigned int m_prgPageCount;
+    unsigned int m_chrPageCount;
+};
@@ -4,4 +4,7 @@
 Mapper::Mapper(Cart& cart) : m_cart(cart) {}
 Mapper::~Mapper() {}
 
-void Mapper::reset() {}
\ No newline at end of file
+void Mapper::reset() {}
+
+bool Mapper::hasScanlineCounter() const { return false; }
+void Mapper::clockScanlineCounter() {}
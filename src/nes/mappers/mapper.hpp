@@ -1,9 +1,18 @@
+#pragma once
+
 #include <cstdint>
+#include <memory>
 
 class Cart;
+class BankedMapper;
 
 class Mapper {
 public:
+    // Creates the mapper registered for an iNES mapper number, nullptr if unsupported.
+    // All of them are banked, so Cart can read their pages directly.
+    static std::shared_ptr<BankedMapper> create(uint8_t id, Cart& cart);
+    static bool isSupported(uint8_t id);
+
     Mapper(Cart& cart);
     virtual ~Mapper();
 
@@ -13,8 +22,15 @@ public:
     
     virtual uint8_t readbPpu(uint16_t address) = 0;
     virtual void writebPpu(uint16_t address, uint8_t value) = 0;
+    virtual void translatePpu(uint16_t addressIn, uint8_t& bankOut, uint16_t& addressOut) = 0;
 
     virtual void reset();
+
+    // Scanline counters clocked by rising edges of PPU A12 (MMC3). The PPU
+    // predicts the edges from its fetch schedule instead of watching the bus.
+    virtual bool hasScanlineCounter() const;
+    virtual void clockScanlineCounter();
+
 protected:
     Cart& m_cart;
 };
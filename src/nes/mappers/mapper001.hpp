@@ -1,15 +1,19 @@
-#include "mapper.hpp"
+#pragma once
+
+#include "bankedmapper.hpp"
 #include "defs.hpp"
 
 class Cart;
 
-class Mapper001 : public Mapper {
+// MMC1: registers are written serially, one bit per write
+// https://wiki.nesdev.com/w/index.php/MMC1
+class Mapper001 final : public BankedMapper {
 public:
     PACK(union Control {
         struct {
             uint8_t mirroring : 2;
             uint8_t prgMode   : 2;
-            uint8_t chrMode   : 2;
+            uint8_t chrMode   : 1;
         };
         
         uint8_t value;
@@ -18,25 +22,26 @@ public:
     Mapper001(Cart&);
     ~Mapper001();
 
-    virtual uint8_t readbCpu(uint16_t address);
-    virtual void writebCpu(uint16_t address, uint8_t value);
-    virtual void translateCpu(uint16_t addressIn, uint8_t& bankOut, uint16_t& addressOut);
+    virtual void reset();
 
-    virtual uint8_t readbPpu(uint16_t address);
-    virtual void writebPpu(uint16_t address, uint8_t value);
+protected:
+    virtual void writeRegister(uint16_t address, uint8_t value);
 
 private:
-    uint8_t* m_prgRam;
-
-    prg_bank* m_prgBanks[2];
-
     unsigned int m_counter = 0;
     unsigned int m_shifter = 0;
 
+    // Writes on the cycle after another one are ignored, only the first of the
+    // two writes of a read-modify-write instruction counts
+    static unsigned long constexpr NO_WRITE = ~0ul;
+    unsigned long m_lastWriteCycle = NO_WRITE;
+
     Control m_control;
     
-    uint8_t m_prgBankSelect;
-    bool m_prgRamEnable;
+    uint8_t m_chrBankSelect[2] = { 0, 1 };
+    uint8_t m_prgBankSelect = 0;
 
     void updatePrgBanks();
+    void updateChrBanks();
+    void updateMirroring();
 };
@@ -0,0 +1,9 @@
+#include "rom.hpp"
+#include "nes/mappers/mapper002.hpp"
+
+Mapper002::Mapper002(Cart& m_cart) : BankedMapper(m_cart) {}
+Mapper002::~Mapper002() {}
+
+void Mapper002::writeRegister(uint16_t address, uint8_t value) {
+    mapPrg(0, 2, busConflict(address, value));
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "bankedmapper.hpp"
+
+class Cart;
+
+// UxROM: switchable 16 KB bank at $8000, last bank fixed at $C000
+// https://wiki.nesdev.com/w/index.php/UxROM
+class Mapper002 final : public BankedMapper {
+public:
+    Mapper002(Cart&);
+    ~Mapper002();
+
+protected:
+    virtual void writeRegister(uint16_t address, uint8_t value);
+};
@@ -0,0 +1,9 @@
+#include "rom.hpp"
+#include "nes/mappers/mapper003.hpp"
+
+Mapper003::Mapper003(Cart& m_cart) : BankedMapper(m_cart) {}
+Mapper003::~Mapper003() {}
+
+void Mapper003::writeRegister(uint16_t address, uint8_t value) {
+    mapChr(0, 8, busConflict(address, value));
+}
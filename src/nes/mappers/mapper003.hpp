@@ -0,0 +1,16 @@
+#pragma once
+
+#include "bankedmapper.hpp"
+
+class Cart;
+
+// CNROM: NROM with a switchable 8 KB CHR bank
+// https://wiki.nesdev.com/w/index.php/CNROM
+class Mapper003 final : public BankedMapper {
+public:
+    Mapper003(Cart&);
+    ~Mapper003();
+
+protected:
+    virtual void writeRegister(uint16_t address, uint8_t value);
+};
@@ -0,0 +1,86 @@
+#include "core/util.hpp"
+#include "rom.hpp"
+#include "nes/mappers/mapper004.hpp"
+
+Mapper004::Mapper004(Cart& m_cart) : BankedMapper(m_cart) {
+    updateBanks();
+}
+
+Mapper004::~Mapper004() {}
+
+void Mapper004::reset() {
+    m_irqCounter = 0;
+    m_irqReload = false;
+    m_irqEnable = false;
+    m_cart.setIrq(false);
+}
+
+void Mapper004::updateBanks() {
+    // Bank 6 is either at $8000 or at $C000, the other one holds the second to last bank
+    bool prgMode = m_bankSelect & 0x40;
+    mapPrg(0, 1, prgMode ? -2 : m_bankRegisters[6]);
+    mapPrg(1, 1, m_bankRegisters[7]);
+    mapPrg(2, 1, prgMode ? m_bankRegisters[6] : -2);
+    mapPrg(3, 1, -1);
+
+    // Two 2 KB banks and four 1 KB banks, halves swapped by CHR A12 inversion
+    unsigned int inversion = (m_bankSelect & 0x80) ? 4 : 0;
+    mapChr(0 ^ inversion, 2, m_bankRegisters[0] >> 1);
+    mapChr(2 ^ inversion, 2, m_bankRegisters[1] >> 1);
+    mapChr(4 ^ inversion, 1, m_bankRegisters[2]);
+    mapChr(5 ^ inversion, 1, m_bankRegisters[3]);
+    mapChr(6 ^ inversion, 1, m_bankRegisters[4]);
+    mapChr(7 ^ inversion, 1, m_bankRegisters[5]);
+}
+
+void Mapper004::writeRegister(uint16_t address, uint8_t value) {
+    // Each 8 KB range holds two registers, selected by the lowest address bit
+    switch (address & 0xe001) {
+    case 0x8000:
+        m_bankSelect = value;
+        updateBanks();
+        break;
+    case 0x8001:
+        m_bankRegisters[m_bankSelect & 0x07] = value;
+        updateBanks();
+        break;
+    case 0xa000:
+        // Carts with four screen VRAM have hardwired mirroring
+        if (!m_cart.m_header->hasVram) {
+            m_cart.setMirroring((value & 0x01) ? Mirroring::Horizontal : Mirroring::Vertical);
+        }
+        break;
+    case 0xa001:
+        m_prgRamEnable = value & 0x80;
+        m_prgRamWriteProtect = value & 0x40;
+        break;
+    case 0xc000:
+        m_irqLatch = value;
+        break;
+    case 0xc001:
+        // The counter is reloaded on the next rising edge of A12
+        m_irqCounter = 0;
+        m_irqReload = true;
+        break;
+    case 0xe000:
+        m_irqEnable = false;
+        m_cart.setIrq(false);
+        break;
+    case 0xe001:
+        m_irqEnable = true;
+        break;
+    }
+}
+
+void Mapper004::clockScanlineCounter() {
+    if (m_irqCounter == 0 || m_irqReload) {
+        m_irqCounter = m_irqLatch;
+        m_irqReload = false;
+    } else {
+        m_irqCounter--;
+    }
+
+    if (m_irqCounter == 0 && m_irqEnable) {
+        m_cart.setIrq(true);
+    }
+}
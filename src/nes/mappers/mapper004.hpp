@@ -0,0 +1,32 @@
+#pragma once
+
+#include "bankedmapper.hpp"
+
+class Cart;
+
+// MMC3: 8 KB PRG ROM banks, 1 and 2 KB CHR banks and a scanline IRQ counter
+// https://wiki.nesdev.com/w/index.php/MMC3
+class Mapper004 final : public BankedMapper {
+public:
+    Mapper004(Cart&);
+    ~Mapper004();
+
+    virtual void reset();
+
+    virtual bool hasScanlineCounter() const { return true; }
+    virtual void clockScanlineCounter();
+
+protected:
+    virtual void writeRegister(uint16_t address, uint8_t value);
+
+private:
+    uint8_t m_bankSelect = 0;
+    uint8_t m_bankRegisters[8] = { 0, 2, 4, 5, 6, 7, 0, 1 };
+
+    uint8_t m_irqLatch = 0;
+    uint8_t m_irqCounter = 0;
+    bool m_irqReload = false;
+    bool m_irqEnable = false;
+
+    void updateBanks();
+};
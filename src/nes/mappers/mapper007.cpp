@@ -0,0 +1,15 @@
+#include "rom.hpp"
+#include "nes/mappers/mapper007.hpp"
+
+Mapper007::Mapper007(Cart& m_cart) : BankedMapper(m_cart) {
+    mapPrg(0, 4, 0);
+    m_cart.setMirroring(Mirroring::SingleScreenLow);
+}
+
+Mapper007::~Mapper007() {}
+
+// AOROM boards have no bus conflicts, the register is written as is
+void Mapper007::writeRegister(uint16_t address, uint8_t value) {
+    mapPrg(0, 4, value & 0x07);
+    m_cart.setMirroring((value & 0x10) ? Mirroring::SingleScreenHigh : Mirroring::SingleScreenLow);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "bankedmapper.hpp"
+
+class Cart;
+
+// AxROM: switchable 32 KB PRG bank and single screen mirroring, CHR RAM
+// https://wiki.nesdev.com/w/index.php/AxROM
+class Mapper007 final : public BankedMapper {
+public:
+    Mapper007(Cart&);
+    ~Mapper007();
+
+protected:
+    virtual void writeRegister(uint16_t address, uint8_t value);
+};
@@ -0,0 +1,14 @@
+#include "rom.hpp"
+#include "nes/mappers/mapper066.hpp"
+
+Mapper066::Mapper066(Cart& m_cart) : BankedMapper(m_cart) {
+    mapPrg(0, 4, 0);
+}
+
+Mapper066::~Mapper066() {}
+
+void Mapper066::writeRegister(uint16_t address, uint8_t value) {
+    value = busConflict(address, value);
+    mapPrg(0, 4, (value >> 4) & 0x03);
+    mapChr(0, 8, value & 0x03);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "bankedmapper.hpp"
+
+class Cart;
+
+// GxROM: switchable 32 KB PRG bank and 8 KB CHR bank
+// https://wiki.nesdev.com/w/index.php/GxROM
+class Mapper066 final : public BankedMapper {
+public:
+    Mapper066(Cart&);
+    ~Mapper066();
+
+protected:
+    virtual void writeRegister(uint16_t address, uint8_t value);
+};
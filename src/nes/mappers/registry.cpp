@@ -0,0 +1,48 @@
+#include "rom.hpp"
+#include "nes/mappers/mapper.hpp"
+#include "nes/mappers/mapper000.hpp"
+#include "nes/mappers/mapper001.hpp"
+#include "nes/mappers/mapper002.hpp"
+#include "nes/mappers/mapper003.hpp"
+#include "nes/mappers/mapper004.hpp"
+#include "nes/mappers/mapper007.hpp"
+#include "nes/mappers/mapper066.hpp"
+
+template<typename T>
+static std::shared_ptr<BankedMapper> makeMapper(Cart& cart) {
+    return std::make_shared<T>(cart);
+}
+
+struct MapperEntry {
+    uint8_t id;
+    std::shared_ptr<BankedMapper> (*create)(Cart&);
+};
+
+// Supported mappers by iNES mapper number. Adding a mapper only takes an entry here.
+static const MapperEntry registry[] = {
+    { 0, makeMapper<Mapper000> },
+    { 1, makeMapper<Mapper001> },
+    { 2, makeMapper<Mapper002> },
+    { 3, makeMapper<Mapper003> },
+    { 4, makeMapper<Mapper004> },
+    { 7, makeMapper<Mapper007> },
+    { 66, makeMapper<Mapper066> },
+};
+
+static const MapperEntry* findEntry(uint8_t id) {
+    for (const MapperEntry& entry : registry) {
+        if (entry.id == id) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<BankedMapper> Mapper::create(uint8_t id, Cart& cart) {
+    const MapperEntry* entry = findEntry(id);
+    return entry ? entry->create(cart) : nullptr;
+}
+
+bool Mapper::isSupported(uint8_t id) {
+    return findEntry(id) != nullptr;
+}
@@ -1,9 +1,17 @@
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <miniz.h>
 
 #include "core/util.hpp"
+#include "core/tracer.hpp"
 #include "emu.hpp"
 #include "ppu.hpp"
 #include "rom.hpp"
+#include "cdl.hpp"
 
 /*
  * Notes:
@@ -30,10 +38,121 @@ namespace sm = StreamManipulators;
     } \
 }
 
+// Palette entry backing each palette address, the
+// backdrop entries of the sprite palettes are mirrors
+static const uint8_t paletteMirrors[0x20] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+    0x00, 0x11, 0x12, 0x13, 0x04, 0x15, 0x16, 0x17,
+    0x08, 0x19, 0x1a, 0x1b, 0x0c, 0x1d, 0x1e, 0x1f,
+};
+
+PPU::PPU(Emu& emu, std::shared_ptr<Cart> cart) : m_emu(emu), m_cart(cart) {
+    updateNametables();
+}
+
+PPU::~PPU() {
+    m_cart->setMirroringFn(nullptr);
+}
+
+void PPU::updateNametables() {
+    for (uint8_t i = 0; i < 4; i++) {
+        m_nametables[i] = &m_vram[m_cart->getNameTable(i)];
+    }
+}
+
+void PPU::setFrameBuffer(uint8_t* buffer) {
+    buffer = buffer ? buffer : m_frameBuffer;
+    if (buffer != m_frame) {
+        memcpy(buffer, m_frame, SCREEN_WIDTH * SCREEN_HEIGHT);
+        m_frame = buffer;
+    }
+}
+
 void PPU::setPixelFn(std::function<void(unsigned int, unsigned int, unsigned int)> fn) {
     m_setPixel = fn;
 }
 
+uint32_t PPU::hashState(uint32_t crc) const {
+    const uint8_t registers[] = {
+        uint8_t(m_r_v.word), uint8_t(m_r_v.word >> 8),
+        uint8_t(m_r_t.word), uint8_t(m_r_t.word >> 8),
+        m_r_x, m_r_mask.field, m_r_status.field,
+    };
+
+    mz_ulong result = mz_crc32(crc, registers, sizeof(registers));
+    result = mz_crc32(result, m_vram, sizeof(m_vram));
+    result = mz_crc32(result, m_palette, sizeof(m_palette));
+    result = mz_crc32(result, m_oam.data, sizeof(m_oam.data));
+    result = mz_crc32(result, m_frame, SCREEN_WIDTH * SCREEN_HEIGHT);
+    return uint32_t(result);
+}
+
+uint8_t PPU::peekStatus() const {
+    StatusV status = m_r_status;
+    status.vblank   = m_f_statusVblank;
+    status.overflow = m_f_statusOverflow;
+    status.sprZero  = m_f_statusSprZero;
+    return status.field;
+}
+
+unsigned int PPU::dotsUntilEvent(bool watchStatus, bool watchIrq) const {
+    unsigned int constexpr DOTS = 341;
+    unsigned int position = m_scanline * DOTS + m_sl_cycle;
+
+    // The last dot of the pre-render line starts the next frame, stepFrame stops there
+    unsigned int next = 262 * DOTS - 1;
+    auto until = [&](unsigned int scanline, unsigned int dot) {
+        unsigned int event = scanline * DOTS + dot;
+        if (event >= position && event < next) {
+            next = event;
+        }
+    };
+
+    until(241, 1);  // Vblank set, NMI
+    until(261, 1);  // Status flags cleared
+
+    bool rendering = m_r_mask.field & RENDERING_ENABLED;
+    if (watchStatus && !m_f_statusSprZero && m_r_mask.bkgEnable && m_r_mask.sprEnable) {
+        // Any dot on the lines sprite 0 covers may set the flag, plus a line for evaluation
+        unsigned int first = m_oam.sprites[0].y;
+        unsigned int last = std::min(first + (m_f_sprSize ? 0x10 : 0x8) + 1, 240u);
+        if (first < last) {
+            until(first, 0);
+            if (m_scanline >= first && m_scanline < last) {
+                return 0;
+            }
+        }
+    }
+
+    if (watchIrq && rendering && m_a12RiseDot != NO_A12_RISE) {
+        // The counter is clocked once on each rendered line
+        unsigned int scanline = m_scanline;
+        if (m_sl_cycle > m_a12RiseDot) {
+            scanline++;
+        }
+        if (scanline >= 240 && scanline < 261) {
+            scanline = 261;
+        }
+        until(scanline, m_a12RiseDot);
+    }
+
+    return next - position;
+}
+
+enum SpriteEvalState {
+    // Copy and check Sprite's Y
+    SPR_EVAL_COPY_Y = 0,
+    // ... If in Range, copy rest of sprite's bytes
+    SPR_EVAL_COPY_REST = 1,
+    // If OAM is full (8 sprites found on scanline)
+    SPR_EVAL_FULL = 2,
+    // If OAM is overflown (9th sprite found on scanline)
+    SPR_EVAL_OVERFLOW = 3,
+    // If all 64 sprites have been found
+    SPR_EVAL_DONE = 4,
+};
+
 void PPU::reset() {
     m_ignoreWrites = true;
 
@@ -51,25 +170,85 @@ void PPU::reset() {
 
     m_bkgPatternTbl = 0;
     m_sprPatternTbl = 0;
+    updateA12Rise();
 
     m_oamAddrExt = 0;
     m_oamAddrInt = 0;
 
     m_oam.data[0x120] = 0xff;
+
+    m_cart->setMirroringFn([this]() { updateNametables(); });
+    updateNametables();
+
+    m_sprEvalState = SPR_EVAL_COPY_Y;
+    m_sprFetch = false;
+    m_sprIndex = 0;
+
+    m_oamAccessedMidRender = false;
+    m_sprEvalExact = false;
+    rebuildSpriteLines();
 }
 
-enum SpriteEvalState {
-    // Copy and check Sprite's Y
-    SPR_EVAL_COPY_Y = 0,
-    // ... If in Range, copy rest of sprite's bytes
-    SPR_EVAL_COPY_REST = 1,
-    // If OAM is full (8 sprites found on scanline)
-    SPR_EVAL_FULL = 2,
-    // If OAM is overflown (9th sprite found on scanline)
-    SPR_EVAL_OVERFLOW = 3,
-    // If all 64 sprites have been found
-    SPR_EVAL_DONE = 4,
-};
+static inline unsigned int lowestBit(uint64_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return index;
+#else
+    return __builtin_ctzll(mask);
+#endif
+}
+
+void PPU::updateSpriteLines(unsigned int sprite, bool set) {
+    unsigned int y = m_oam.sprites[sprite].y;
+    unsigned int end = std::min(y + (m_f_sprSize ? 0x10 : 0x8), 240u);
+    uint64_t bit = uint64_t(1) << sprite;
+    for (unsigned int line = y; line < end; line++) {
+        if (set) {
+            m_sprLines[line] |= bit;
+        } else {
+            m_sprLines[line] &= ~bit;
+        }
+    }
+}
+
+void PPU::rebuildSpriteLines() {
+    memset(m_sprLines, 0, sizeof(m_sprLines));
+    for (unsigned int sprite = 0; sprite < 64; sprite++) {
+        updateSpriteLines(sprite, true);
+    }
+}
+
+// Produces the same secondary OAM and OAM addresses as the
+// dot by dot evaluation does by the end of dot 256
+void PPU::evaluateSprites() {
+    memset(&m_oam.data[0x100], m_oam.data[0x120], 0x20);
+
+    uint64_t sprites = m_sprLines[m_scanline];
+    m_sprZeroOnSl = sprites & 1;
+
+    unsigned int count = 0;
+    unsigned int sprite = 0;
+    while (sprites && count < 8) {
+        sprite = lowestBit(sprites);
+        sprites &= sprites - 1;
+        memcpy(&m_oam.data[0x100 | (count * 4)], &m_oam.data[sprite * 4], 4);
+        count++;
+    }
+
+    if (count == 8 && sprite < 63) {
+        // Secondary OAM is full, evaluation stops at the next sprite
+        m_oamAddrExt = uint8_t((sprite + 1) * 4);
+        m_oamAddrInt = 0;
+    } else {
+        // The Y of every sprite out of range is written to the next free slot
+        if (count < 8 && !(m_sprLines[m_scanline] & (uint64_t(1) << 63))) {
+            m_oam.data[0x100 | (count * 4)] = m_oam.sprites[63].y;
+        }
+        m_oamAddrExt = 0;
+        m_oamAddrInt = (count * 4) & 0x1f;
+    }
+}
 
 void PPU::cycle() {
     if (!isRenderingEnabled()) {
@@ -163,6 +342,13 @@ void PPU::cycle() {
             m_oamPtr = 0;
             m_oamAddrInt = 0;
             m_oamAddrExt = 0;
+
+            m_sprEvalExact = m_oamAccessedMidRender;
+        }
+        else if (!m_sprEvalExact) {
+            if (m_sl_cycle == 65) {
+                evaluateSprites();
+            }
         }
         // Clear Secondary OAM
         else if (m_sl_cycle > 0 && m_sl_cycle <= 64) {
@@ -176,12 +362,11 @@ void PPU::cycle() {
         }
         // Sprite Evaluation
         else if (m_sl_cycle <= 256) {
-            static int sprEvalState;
             if (m_sl_cycle == 65) {
-                sprEvalState = SPR_EVAL_COPY_Y;
+                m_sprEvalState = SPR_EVAL_COPY_Y;
             }
 
-            switch (sprEvalState) {
+            switch (m_sprEvalState) {
             case SPR_EVAL_COPY_Y:
                 if (m_sl_cycle & 1) {
                     m_sprTmp = m_oam.data[m_oamPtr = m_oamAddrExt];
@@ -189,7 +374,7 @@ void PPU::cycle() {
                 else {
                     m_oam.data[m_oamPtr = (0x100 | m_oamAddrInt)] = m_sprTmp;
                     if (sprOnScanline(m_sprTmp)) {
-                        sprEvalState = SPR_EVAL_COPY_REST;
+                        m_sprEvalState = SPR_EVAL_COPY_REST;
                         if (m_oamAddrExt == 0) {
                             // Sprite Zero is rendered on this scanline
                             m_sprZeroOnSl = true;
@@ -200,7 +385,7 @@ void PPU::cycle() {
                     else {
                         m_oamAddrExt += 4; m_oamAddrExt &= 0xff;
                         if (m_oamAddrExt == 0) {  // Check if we wrapped to 0 (all 64 sprites done)
-                            sprEvalState = SPR_EVAL_DONE;
+                            m_sprEvalState = SPR_EVAL_DONE;
                         }
                     }
                 }
@@ -214,14 +399,14 @@ void PPU::cycle() {
                     m_oamAddrExt += 1; m_oamAddrExt &= 0xff;
                     m_oamAddrInt += 1; m_oamAddrInt &= 0x1f;
                     if (m_oamAddrExt == 0) {  // Check if we wrapped to 0 (all 64 sprites done)
-                        sprEvalState = SPR_EVAL_DONE;
+                        m_sprEvalState = SPR_EVAL_DONE;
                     }
                     else if ((m_oamAddrExt & 0x3) == 0) {  // ... or we're starting the next sprite
                         if (m_oamAddrInt == 0) { // ... but secondary oam is full
-                            sprEvalState = SPR_EVAL_FULL;
+                            m_sprEvalState = SPR_EVAL_FULL;
                         }
                         else {
-                            sprEvalState = SPR_EVAL_COPY_Y;
+                            m_sprEvalState = SPR_EVAL_COPY_Y;
                         }
                     }
                 }
@@ -243,11 +428,8 @@ void PPU::cycle() {
 
         if ((m_sl_cycle > 0 && m_sl_cycle < 337)) {
 
-            static bool doSprites;
-            static uint16_t sprIndex;
-
-            if (doSprites = (m_sl_cycle > 256 && m_sl_cycle <= 320)) {
-                sprIndex = (m_sl_cycle - 257) / 8;
+            if (m_sprFetch = (m_sl_cycle > 256 && m_sl_cycle <= 320)) {
+                m_sprIndex = (m_sl_cycle - 257) / 8;
             }
 
             updateShiftRegs();
@@ -259,8 +441,8 @@ void PPU::cycle() {
                 m_latch_ntByte = readVram(0x2000 | (m_r_v.word & 0xfff));
                 break;
             case 2: // Fetch BG Attribute Byte / Fetch Sprite Attribute Byte
-                if (doSprites) {
-                    m_sprAttributes[sprIndex] = m_oam.sprites[64 + sprIndex].attributes;
+                if (m_sprFetch) {
+                    m_sprAttributes[m_sprIndex] = m_oam.sprites[64 + m_sprIndex].attributes;
                 }
 
                 m_latch_atByte = readVram(0x23c0
@@ -274,23 +456,23 @@ void PPU::cycle() {
                 m_latch_atByte &= 0b11;
                 break;
             case 3: // Fetch Sprite X Coordinate
-                if (doSprites) {
-                    m_sprCounter[sprIndex] = m_oam.sprites[64 + sprIndex].x;
+                if (m_sprFetch) {
+                    m_sprCounter[m_sprIndex] = m_oam.sprites[64 + m_sprIndex].x;
                 }
                 break;
             case 4: // Fetch BG / Sprite Lo Tile Byte
-                if (doSprites) {
+                if (m_sprFetch) {
                     // TODO Support for 8x16 Sprites
-                    if (m_oam.sprites[64 + sprIndex].attributes.field == 0xff) {
+                    if (m_oam.sprites[64 + m_sprIndex].attributes.field == 0xff) {
                         // If tile == 0xff render transparently
-                        m_sprTileLo[sprIndex] = 0;
+                        m_sprTileLo[m_sprIndex] = 0;
                     }
                     else {
-                        unsigned int tile = m_oam.sprites[64 + sprIndex].tileIndex;
-                        unsigned int offset = m_sprAttributes[sprIndex].vflip ? 
-                            (m_oam.sprites[64 + sprIndex].y + 7 - m_scanline) :
-                            (m_scanline - m_oam.sprites[64 + sprIndex].y);
-                        m_sprTileLo[sprIndex] = readVram(m_sprPatternTbl
+                        unsigned int tile = m_oam.sprites[64 + m_sprIndex].tileIndex;
+                        unsigned int offset = m_sprAttributes[m_sprIndex].vflip ? 
+                            (m_oam.sprites[64 + m_sprIndex].y + 7 - m_scanline) :
+                            (m_scanline - m_oam.sprites[64 + m_sprIndex].y);
+                        m_sprTileLo[m_sprIndex] = readVram(m_sprPatternTbl
                             + ((uint16_t)tile << 4)
                             + offset
                             + 0);
@@ -304,17 +486,17 @@ void PPU::cycle() {
                 }
                 break;
             case 6: // Fetch BG / Sprite Hi Tile Byte
-                if (doSprites) {
+                if (m_sprFetch) {
                     // TODO Support for 8x16 Sprites
-                    if (m_oam.sprites[64 + sprIndex].attributes.field == 0xff) {
+                    if (m_oam.sprites[64 + m_sprIndex].attributes.field == 0xff) {
                         // If tile == 0xff render transparently
-                        m_sprTileHi[sprIndex] = 0;
+                        m_sprTileHi[m_sprIndex] = 0;
                     } else {
-                        unsigned int tile = m_oam.sprites[64 + sprIndex].tileIndex;
-                        unsigned int offset = m_sprAttributes[sprIndex].vflip ?
-                            (m_oam.sprites[64 + sprIndex].y + 7 - m_scanline) : 
-                            (m_scanline - m_oam.sprites[64 + sprIndex].y);
-                        m_sprTileHi[sprIndex] = readVram(m_sprPatternTbl
+                        unsigned int tile = m_oam.sprites[64 + m_sprIndex].tileIndex;
+                        unsigned int offset = m_sprAttributes[m_sprIndex].vflip ?
+                            (m_oam.sprites[64 + m_sprIndex].y + 7 - m_scanline) : 
+                            (m_scanline - m_oam.sprites[64 + m_sprIndex].y);
+                        m_sprTileHi[m_sprIndex] = readVram(m_sprPatternTbl
                             + ((uint16_t)tile << 4)
                             + offset
                             + 8);
@@ -328,7 +510,7 @@ void PPU::cycle() {
                 }
                 break;
             case 7: // Increase V horizontally
-                if (!doSprites) {
+                if (!m_sprFetch) {
                     incScrollX();
                 }
                 break;
@@ -347,6 +529,10 @@ void PPU::cycle() {
         if (m_sl_cycle == 338 || m_sl_cycle == 340) {
             m_latch_ntByte = readVram(0x2000 | (m_r_v.word & 0xfff));
         }
+
+        if (m_sl_cycle == m_a12RiseDot) {
+            m_cart->clockScanlineCounter();
+        }
     }
 
     // ------------- Reset V --------------------
@@ -380,6 +566,7 @@ void PPU::run(unsigned int cycles) {
 
         // ----- Update Status Flags and raise NMI ---
         if (m_scanline == 241 && m_sl_cycle == 1) {
+            Tracer::instant("Vblank", "ppu");
             m_f_statusVblank = true;
             if (m_f_vblankNmi) {
                 m_emu.m_nmi_request = true;
@@ -391,14 +578,24 @@ void PPU::run(unsigned int cycles) {
             m_f_statusVblank = false;
             m_f_statusOverflow = false;
             m_f_statusSprZero = false;
+
+            // Accesses of the last frame don't affect the evaluation of the next
+            m_oamAccessedMidRender = false;
         }
 
         // ----------- Rendering a Pixel --------------
+        bool advanceSprites = true;
         if (m_scanline >= 0 && m_scanline < 240) {
             if (m_sl_cycle > 0 && m_sl_cycle < 257) {
+                // Without video the only observable effect is the sprite 0 hit. The sprites
+                // move on until it's known whether sprite 0 is on this scanline.
+                bool sprZeroPending = m_sprZeroOnSl && !m_f_statusSprZero;
+                bool compose = !m_skipRender || (sprZeroPending && m_r_mask.bkgEnable && m_r_mask.sprEnable);
+                advanceSprites = !m_skipRender || sprZeroPending || m_sl_cycle <= SPR_ZERO_KNOWN_DOT;
+
                 // Background Value
                 uint8_t bgPalIdx = 0;
-                if (m_r_mask.bkgEnable) {
+                if (compose && m_r_mask.bkgEnable) {
                     uint16_t bit = 0x8000 >> m_r_x;
                 
                     bgPalIdx = ((m_shiftPatternLo & bit) ? 0b0001 : 0)
@@ -408,19 +605,19 @@ void PPU::run(unsigned int cycles) {
                 }
 
                 uint8_t fgPalIdx = 0;
-                int sprIndex = 0;
-                if (m_r_mask.sprEnable) {
-                    for (sprIndex = 0; sprIndex < 8; sprIndex++) {
-                        if (m_sprCounter[sprIndex] > 0) continue;
+                int m_sprIndex = 0;
+                if (compose && m_r_mask.sprEnable) {
+                    for (m_sprIndex = 0; m_sprIndex < 8; m_sprIndex++) {
+                        if (m_sprCounter[m_sprIndex] > 0) continue;
     
-                        if (m_sprAttributes[sprIndex].hflip) {
-                            fgPalIdx = ((m_sprTileLo[sprIndex] & 0x01) ? 0b0001 : 0)
-                                     | ((m_sprTileHi[sprIndex] & 0x01) ? 0b0010 : 0)
-                                     | (m_sprAttributes[sprIndex].palette << 2);
+                        if (m_sprAttributes[m_sprIndex].hflip) {
+                            fgPalIdx = ((m_sprTileLo[m_sprIndex] & 0x01) ? 0b0001 : 0)
+                                     | ((m_sprTileHi[m_sprIndex] & 0x01) ? 0b0010 : 0)
+                                     | (m_sprAttributes[m_sprIndex].palette << 2);
                         } else {
-                            fgPalIdx = ((m_sprTileLo[sprIndex] & 0x80) ? 0b0001 : 0)
-                                     | ((m_sprTileHi[sprIndex] & 0x80) ? 0b0010 : 0)
-                                     | (m_sprAttributes[sprIndex].palette << 2);
+                            fgPalIdx = ((m_sprTileLo[m_sprIndex] & 0x80) ? 0b0001 : 0)
+                                     | ((m_sprTileHi[m_sprIndex] & 0x80) ? 0b0010 : 0)
+                                     | (m_sprAttributes[m_sprIndex].palette << 2);
                         }
 
                         if ((fgPalIdx & 0x3) != 0) {
@@ -429,7 +626,9 @@ void PPU::run(unsigned int cycles) {
                             fgPalIdx = 0;
                         }
                     }
+                }
 
+                if (advanceSprites && m_r_mask.sprEnable) {
                     for (int i = 0; i < 8; i++) {
                         if (m_sprCounter[i] > 0) continue;
     
@@ -443,14 +642,14 @@ void PPU::run(unsigned int cycles) {
                     }
                 }
 
-                if (isRenderingEnabled()) {
+                if (compose && isRenderingEnabled()) {
                     uint8_t value;
                     if ((fgPalIdx & 0x3) == 0) {
                         value = m_palette[BG_LUT[bgPalIdx]];
                     } else if ((bgPalIdx & 0x3) == 0) {
                         value = m_palette[FG_LUT[fgPalIdx]];
-                    } else if (m_sprAttributes[sprIndex].priority) {
-                        if (m_sprZeroOnSl && sprIndex == 0) {
+                    } else if (m_sprAttributes[m_sprIndex].priority) {
+                        if (m_sprZeroOnSl && m_sprIndex == 0) {
                             m_f_statusSprZero = true;
                         }
                         value = m_palette[BG_LUT[bgPalIdx]];
@@ -458,15 +657,18 @@ void PPU::run(unsigned int cycles) {
                         value = m_palette[FG_LUT[fgPalIdx]];
                     }
 
-                    if (m_setPixel) {
-                        m_setPixel(m_sl_cycle - 1, m_scanline, value);
+                    if (!m_skipRender) {
+                        m_frame[m_scanline * SCREEN_WIDTH + m_sl_cycle - 1] = value;
+                        if (m_setPixel) {
+                            m_setPixel(m_sl_cycle - 1, m_scanline, value);
+                        }
                     }
                 }
             }
         }
 
         // ----- Update Sprite Counters -----------------
-        if (isRenderingEnabled() && m_sl_cycle > 0 && m_sl_cycle <= 256) {
+        if (advanceSprites && isRenderingEnabled() && m_sl_cycle > 0 && m_sl_cycle <= 256) {
             for (int i = 0; i < 8; i++)
                 if (m_sprCounter[i] > 0)
                     m_sprCounter[i]--;
@@ -486,6 +688,7 @@ void PPU::run(unsigned int cycles) {
             m_scanline++;
             // Next Frame
             if (m_scanline > 261) {
+                Tracer::instant("Frame Start", "ppu");
                 m_scanline = 0;
                 m_f_oddFrame = !m_f_oddFrame;
             }
@@ -501,6 +704,7 @@ uint8_t PPU::readRegister(uint8_t reg) {
     case PPUDATA:   return readData();
     case OAMDATA:   
         // TODO While Rendering this leaks internal OAM
+        m_oamAccessedMidRender |= m_scanline < 240 && isRenderingEnabled();
         return m_oam.data[m_oamAddrExt];
     default:
         LOG_ERR << sm::hex(m_emu.getOpcodeAddress())
@@ -520,8 +724,22 @@ void PPU::writeRegister(uint8_t reg, uint8_t value) {
     case PPUADDR:   CHECK_WRITE; writeAddr(value); break;
     case PPUMASK:   CHECK_WRITE; m_r_mask.field = value; break;
     case PPUDATA:   writeData(value); break;
-    case OAMADDR:   m_oamAddrExt = value; break;
-    case OAMDATA:   m_oam.data[m_oamAddrExt++] = value; break;
+    case OAMADDR:   
+        m_oamAccessedMidRender |= m_scanline < 240 && isRenderingEnabled();
+        m_oamAddrExt = value; 
+        break;
+    case OAMDATA:   
+        m_oamAccessedMidRender |= m_scanline < 240 && isRenderingEnabled();
+        if ((m_oamAddrExt & 0x3) == 0) {
+            // Sprite's Y changes
+            updateSpriteLines(m_oamAddrExt / 4, false);
+            m_oam.data[m_oamAddrExt] = value;
+            updateSpriteLines(m_oamAddrExt / 4, true);
+        } else {
+            m_oam.data[m_oamAddrExt] = value;
+        }
+        m_oamAddrExt++;
+        break;
     default:
         LOG_ERR << sm::hex(m_emu.getOpcodeAddress())
             << " PPU::write_register("
@@ -533,17 +751,43 @@ void PPU::writeRegister(uint8_t reg, uint8_t value) {
     }
 }
 
+// Same as 256 writes to OAMDATA
+void PPU::writeOamDma(const uint8_t* data) {
+    for (unsigned int i = 0; i < 0x100; i++) {
+        m_oam.data[uint8_t(m_oamAddrExt + i)] = data[i];
+    }
+    m_r_status.field = data[0xff];
+    rebuildSpriteLines();
+}
+
 void PPU::writeCtrl(CtrlV v) {
     m_f_vblankNmi = v.vblankNmi;
-    m_f_sprSize = v.sprSize;
+    if (m_f_sprSize != bool(v.sprSize)) {
+        m_f_sprSize = v.sprSize;
+        rebuildSpriteLines();
+    }
     m_f_master = v.masterSlave;
     m_bkgPatternTbl = v.bkgPatternTbl ? 0x1000 : 0x0000;
     m_sprPatternTbl = v.sprPatternTbl ? 0x1000 : 0x0000;
+    updateA12Rise();
     m_r_addressIncrement = v.vramIncrement ? 32 : 1;
     m_r_t.baseNtX = v.baseNtX;
     m_r_t.baseNtY = v.baseNtY;
 }
 
+void PPU::updateA12Rise() {
+    // 8x16 sprites pick their table per tile, unused slots fetch tile $FF from $1000
+    bool sprLo = m_f_sprSize || m_sprPatternTbl == 0x0000;
+    bool sprHi = m_f_sprSize || m_sprPatternTbl == 0x1000;
+    if (!m_cart->hasScanlineCounter()) {
+        m_a12RiseDot = NO_A12_RISE;
+    } else if (m_bkgPatternTbl == 0x0000) {
+        m_a12RiseDot = sprHi ? 260 : NO_A12_RISE;
+    } else {
+        m_a12RiseDot = sprLo ? 324 : NO_A12_RISE;
+    }
+}
+
 void PPU::writeScroll(ScrollV v) {
     if (m_r_addressLatch) {
         m_r_addressLatch = !m_r_addressLatch;
@@ -594,24 +838,14 @@ uint8_t PPU::readStatus() {
 
 uint8_t PPU::readVram(uint16_t address, bool ignorePalette) {
     if (address < 0x2000) {
+        // Only PPUDATA reads ignore the palette, everything else is a rendering fetch
+        m_emu.m_cdl->logChr(address, ignorePalette ? CodeDataLog::CHR_READ : CodeDataLog::CHR_RENDERED);
         return m_cart->readb_ppu(address);
     } else if ((ignorePalette && address < 0x4000) || address < 0x3f00) {
         NameTableAddress a = address;
-        return m_vram[m_cart->getNameTable(a.ntIndex) | a.ntAddress];
+        return m_nametables[a.ntIndex][a.ntAddress];
     } else if (address < 0x4000) {
-        address &= 0x001F;
-        switch (address) {
-        case 0x00: case 0x10: 
-            return m_palette[0x00];
-        case 0x04: case 0x14:
-            return m_palette[0x04];
-        case 0x08: case 0x18:
-            return m_palette[0x08];
-        case 0x0C: case 0x1C:
-            return m_palette[0x0C];
-        default:
-            return m_palette[address];
-        }
+        return m_palette[paletteMirrors[address & 0x1f]];
     } else {
         LOG_ERR << "Illegal VRAM Read @ " << sm::hex(address) << "\n";
     }
@@ -624,26 +858,9 @@ void PPU::writeVram(uint16_t address, uint8_t value) {
         m_cart->writeb_ppu(address, value);
     } else if (address < 0x3f00) {
         NameTableAddress a = address;
-        m_vram[m_cart->getNameTable(a.ntIndex) | a.ntAddress] = value;
+        m_nametables[a.ntIndex][a.ntAddress] = value;
     } else if (address < 0x4000) {
-        address &= 0x001F;
-        switch (address) {
-        case 0x00: case 0x10: 
-            m_palette[0x00] = value;
-            break;
-        case 0x04: case 0x14:
-            m_palette[0x04] = value;
-            break;
-        case 0x08: case 0x18:
-            m_palette[0x08] = value;
-            break;
-        case 0x0C: case 0x1C:
-            m_palette[0x0C] = value;
-            break;
-        default:
-            m_palette[address] = value;
-            break;
-        }
+        m_palette[paletteMirrors[address & 0x1f]] = value;
     } else {
         LOG_ERR << "Illegal VRAM Write @ " << sm::hex(address) << "\n";
     }
@@ -13,6 +13,7 @@ class Emu;
 class PPU {
 private:
     static unsigned int constexpr WARMUP_CYCLES = 88974;
+    static unsigned int constexpr SPR_ZERO_KNOWN_DOT = 66;  // Sprite 0 is the first one evaluated, on dots 65 and 66
     static uint8_t constexpr RENDERING_ENABLED = 0b00011000;
 
 public:
@@ -25,6 +26,9 @@ public:
     static uint8_t constexpr PPUADDR = 0x6;
     static uint8_t constexpr PPUDATA = 0x7;
 
+    static unsigned int constexpr SCREEN_WIDTH = 256;
+    static unsigned int constexpr SCREEN_HEIGHT = 240;
+
     PACK(union OamAttributes {
         uint8_t field;
         struct {
@@ -133,7 +137,8 @@ public:
         T(uint16_t v) : word(v) {}
     });
 
-    PPU(Emu& emu, std::shared_ptr<Cart> cart) : m_emu(emu), m_cart(cart) {}
+    PPU(Emu& emu, std::shared_ptr<Cart> cart);
+    ~PPU();
 
     void setPixelFn(std::function<void(unsigned int, unsigned int, unsigned int)>);
 
@@ -141,6 +146,7 @@ public:
 
     uint8_t readRegister(uint8_t reg);
     void writeRegister(uint8_t reg, uint8_t value);
+    void writeOamDma(const uint8_t* data);
     
     void reset();
     void run(unsigned int cycles);
@@ -153,6 +159,25 @@ public:
 
     const OamEntry* getSprites() { return m_oam.sprites; }
 
+    // Palette values of the last rendered pixels, row by row
+    const uint8_t* getFrame() const { return m_frame; }
+    void setFrameBuffer(uint8_t* buffer);  // SCREEN_WIDTH * SCREEN_HEIGHT bytes owned by the caller, nullptr for the own one. Keeps the contents.
+
+    // Skips composing pixels, the frame is left as it is. Timing, sprite 0 hits,
+    // register side effects and mapper IRQs stay exactly the same.
+    bool m_skipRender = false;
+
+    // Continues a CRC32 over the frame, VRAM, palette, OAM and registers
+    uint32_t hashState(uint32_t crc) const;
+
+    // Status flags as PPUSTATUS returns them, without the side effects of the read
+    uint8_t peekStatus() const;
+
+    // Dots that can run before anything changes for a CPU waiting on PPUSTATUS or
+    // an IRQ: vblank and NMI, the end of the frame, a possible sprite 0 hit and
+    // the mapper's scanline counter. Used to fast-forward idle loops.
+    unsigned int dotsUntilEvent(bool watchStatus, bool watchIrq) const;
+
 private:
     
     __forceinline bool isRenderingEnabled() { return m_r_mask.field & RENDERING_ENABLED; }
@@ -163,6 +188,10 @@ private:
 
     std::shared_ptr<Cart> m_cart;
 
+    void evaluateSprites();
+    void updateSpriteLines(unsigned int sprite, bool set);
+    void rebuildSpriteLines();
+
     uint8_t readVram(uint16_t address, bool ignorePalette = false);
     void writeVram(uint16_t address, uint8_t value);
 
@@ -175,14 +204,17 @@ private:
 
     unsigned long m_cycleCount = 0;
 
-    uint16_t m_oamPtr;
-    uint8_t m_oamAddrExt;
-    uint8_t m_oamAddrInt;
+    uint8_t m_frameBuffer[SCREEN_WIDTH * SCREEN_HEIGHT] = {};
+    uint8_t* m_frame = m_frameBuffer;
+
+    uint16_t m_oamPtr = 0;
+    uint8_t m_oamAddrExt = 0;
+    uint8_t m_oamAddrInt = 0;
 
     union {
         OamEntry sprites[0x48];
         uint8_t data[0x121];
-    } m_oam;
+    } m_oam = {};
     
     bool m_ignoreWrites = true;  // true until the PPU is write-ready, after WARMUP_CYCLES cycles
     bool m_f_oddFrame  = false;  // indicates wether we are on an even or odd frame
@@ -191,10 +223,18 @@ private:
 
     MaskV      m_r_mask = 0;
 
-    uint16_t m_sprPatternTbl;
-    uint16_t m_bkgPatternTbl;
-    bool m_f_sprSize;
-    bool m_f_master;
+    uint16_t m_sprPatternTbl = 0;
+    uint16_t m_bkgPatternTbl = 0;
+    bool m_f_sprSize = false;
+    bool m_f_master = false;
+
+    // Dot of each rendered scanline where PPU A12 rises after being low for a
+    // while, which clocks scanline counters like the one of the MMC3. Follows
+    // from the pattern tables: sprites are fetched from dot 257, the next
+    // line's background from dot 321.
+    static uint16_t constexpr NO_A12_RISE = 0xffff;
+    uint16_t m_a12RiseDot = NO_A12_RISE;
+    void updateA12Rise();
 
     //// Data Read Buffer
     // When PPUDATA two things happen:
@@ -207,7 +247,7 @@ private:
     // This stores the value last written to a PPU register
     // We use this to simulate unset bits on read, see https://wiki.nesdev.com/w/index.php/PPU_registers#PPUSTATUS
     // On Read we update bits 5-7
-    StatusV    m_r_status;
+    StatusV    m_r_status = {};
     bool       m_f_statusVblank = false;
     bool       m_f_statusOverflow = false;
     bool       m_f_statusSprZero = false;
@@ -216,31 +256,44 @@ private:
     uint8_t    m_r_addressIncrement = 1;
     T          m_r_t;
     T          m_r_v;
-    uint8_t    m_r_x;
+    uint8_t    m_r_x = 0;
 
-    uint8_t    m_vram[0x0800];
-    uint8_t    m_palette[0x20];
+    uint8_t    m_vram[0x0800] = {};
+    uint8_t    m_palette[0x20] = {};
+
+    uint8_t*   m_nametables[4];  // Pages of VRAM mapped to $2000, $2400, $2800, $2c00
+    void updateNametables();
 
     // Rendering Background
     
-    uint8_t    m_latch_ntByte;
-    uint8_t    m_latch_atByte;
-    uint8_t    m_latch_tileLo;
-    uint8_t    m_latch_tileHi;
+    uint8_t    m_latch_ntByte = 0;
+    uint8_t    m_latch_atByte = 0;
+    uint8_t    m_latch_tileLo = 0;
+    uint8_t    m_latch_tileHi = 0;
 
-    uint16_t   m_shiftPatternHi;
-    uint16_t   m_shiftPatternLo;
-    uint16_t   m_shiftAttrHi;
-    uint16_t   m_shiftAttrLo;
+    uint16_t   m_shiftPatternHi = 0;
+    uint16_t   m_shiftPatternLo = 0;
+    uint16_t   m_shiftAttrHi = 0;
+    uint16_t   m_shiftAttrLo = 0;
 
     // Rendering Sprites
         
-    uint8_t m_sprTmp;  // temporary for copying between primary and secondary OAM
+    uint8_t m_sprTmp = 0;  // temporary for copying between primary and secondary OAM
+
+    bool m_sprZeroOnSl = false;
+
+    int m_sprEvalState = 0;    // SpriteEvalState of the dot by dot evaluation
+    bool m_sprFetch = false;   // Dots 257-320 fetch sprites instead of tiles
+    uint16_t m_sprIndex = 0;   // Sprite in secondary OAM fetched during m_sprFetch
 
-    bool m_sprZeroOnSl;
+    // Sprites in range of each visible scanline, bit n is set for sprite n.
+    // Kept up to date on OAM writes, so evaluation is a lookup per scanline.
+    uint64_t m_sprLines[SCREEN_HEIGHT];
+    bool m_oamAccessedMidRender = false;  // Switches to dot by dot evaluation, starting at the next scanline
+    bool m_sprEvalExact = false;
 
-    uint8_t m_sprTileLo[8];
-    uint8_t m_sprTileHi[8];
-    uint8_t m_sprCounter[8];
-    OamAttributes m_sprAttributes[8];
+    uint8_t m_sprTileLo[8] = {};
+    uint8_t m_sprTileHi[8] = {};
+    uint8_t m_sprCounter[8] = {};
+    OamAttributes m_sprAttributes[8] = {};
 };
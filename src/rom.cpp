@@ -4,17 +4,74 @@
 #include <iostream>
 #include <miniz.h>
 #include <memory>
+#include <map>
+#include <mutex>
+#include <sstream>
 
 #include "core/util.hpp"
+#include "core/tracer.hpp"
+#include "core/probes.hpp"
 #include "rom.hpp"
-#include "nes/mappers/mapper000.hpp"
+#include "nes/mappers/mapper.hpp"
 
 namespace fs = std::filesystem;
 namespace sm = StreamManipulators;
 
 constexpr uint8_t FLAG_TRAINER = 1 << 2;
 
-uint8_t* nesFromZip(const fs::path& p, size_t& len, std::string& out_name) {
+// Images currently in use, keyed by file identity or, for ZIP archives, by
+// the CRC and size of the packed ROM. Entries expire with their last user.
+static std::mutex imageCacheMutex;
+static std::map<std::string, std::weak_ptr<const RomImage>> imageCache;
+
+static std::shared_ptr<const RomImage> findImage(const std::string& key) {
+    std::lock_guard<std::mutex> lock(imageCacheMutex);
+    auto it = imageCache.find(key);
+    return it != imageCache.end() ? it->second.lock() : nullptr;
+}
+
+// Adds an image unless another thread was faster, returns the cached one
+static std::shared_ptr<const RomImage> cacheImage(const std::string& key, std::shared_ptr<const RomImage> image) {
+    std::lock_guard<std::mutex> lock(imageCacheMutex);
+    std::weak_ptr<const RomImage>& entry = imageCache[key];
+    if (auto cached = entry.lock()) {
+        return cached;
+    }
+    entry = image;
+    return image;
+}
+
+RomImage::RomImage(std::vector<uint8_t> data) : m_buffer(std::move(data)) {
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+}
+
+std::shared_ptr<const RomImage> RomImage::fromNes(const fs::path& p) {
+    std::error_code ec;
+    fs::path canonical = fs::weakly_canonical(p, ec);
+    auto size = fs::file_size(p, ec);
+    auto time = fs::last_write_time(p, ec).time_since_epoch().count();
+    if (ec) {
+        LOG_ERR << "Could not open " << p << "\n";
+        return nullptr;
+    }
+
+    std::stringstream key;
+    key << "file:" << canonical.string() << ":" << size << ":" << time;
+    if (auto cached = findImage(key.str())) {
+        return cached;
+    }
+
+    std::shared_ptr<RomImage> image(new RomImage());
+    if (!image->m_file.openReadOnly(p)) {
+        return nullptr;
+    }
+    image->m_data = image->m_file.data();
+    image->m_size = image->m_file.size();
+    return cacheImage(key.str(), image);
+}
+
+std::shared_ptr<const RomImage> RomImage::fromZip(const fs::path& p, std::string& name) {
     LOG_MSG << "Unzipping " << p << "\n";
 
     mz_zip_archive zip;
@@ -33,65 +90,116 @@ uint8_t* nesFromZip(const fs::path& p, size_t& len, std::string& out_name) {
         fs::path p(pStat.m_filename);
         if (p.extension() == ".nes") {
             LOG_MSG << "Found ROM " << pStat.m_filename << "\n";
-            out_name = pStat.m_filename;
+            name = pStat.m_filename;
             break;
         }
     }
 
     if (i == fileCount) {
         LOG_ERR << "No ROM found in " << p << "\n";
+        mz_zip_reader_end(&zip);
         return nullptr;
     }
 
-    uint8_t* data = (uint8_t*)mz_zip_reader_extract_to_heap(&zip, i, &len, 0);
+    // The central directory already has the checksum, so cached
+    // contents are found without inflating them again
+    std::stringstream key;
+    key << "zip:" << std::hex << pStat.m_crc32 << ":" << std::dec << pStat.m_uncomp_size;
+    std::shared_ptr<const RomImage> image = findImage(key.str());
+    if (!image) {
+        std::vector<uint8_t> data(size_t(pStat.m_uncomp_size));
+        if (mz_zip_reader_extract_to_mem(&zip, i, data.data(), data.size(), 0)) {
+            image = cacheImage(key.str(), std::make_shared<const RomImage>(std::move(data)));
+        } else {
+            LOG_ERR << "Failed unzipping " << pStat.m_filename << "\n";
+        }
+    }
+
     mz_zip_reader_end(&zip);
-    return data;
+    return image;
 }
 
-std::shared_ptr<Cart> Cart::fromFile(const fs::path& p) {
+std::shared_ptr<Cart> Cart::fromFile(const fs::path& p, bool mapSave) {
+    Tracer::Span span("Load ROM", "io");
+    STA_PROBE1(rom__load__start, p.c_str());
     LOG_MSG << "Loading " << p << "\n";
     
     std::string name;
-    uint8_t* data;
-    size_t len;
+    std::shared_ptr<const RomImage> image;
     if (p.extension() == ".zip") {
-        data = nesFromZip(p, len, name);
-        if (data == nullptr) {
-            return nullptr;
-        }
+        image = RomImage::fromZip(p, name);
     } else {
-        std::ifstream in(p, std::ifstream::binary);
-        data = readFile(in, &len);
-        in.close();
-
+        image = RomImage::fromNes(p);
         name = p.filename().string();
     }
-    
+    if (image == nullptr) {
+        return nullptr;
+    }
+
+    fs::path savePath;
+    if (mapSave) {
+        savePath = p;
+        savePath.replace_extension(".sav");
+    }
+    return fromImage(image, name, savePath);
+}
+
+std::shared_ptr<Cart> Cart::fromImage(std::shared_ptr<const RomImage> image, std::string name, const fs::path& savePath) {
     // Check if we have a valid .nes rom
-    if (INES_MAGIC != ((InesHeader*)data)->magic) {
+    if (!image || !isValidImage(*image)) {
         LOG_ERR << "ROM is not a valid .nes rom\n";
         return nullptr;
     }
 
-    return std::make_shared<Cart>(data, name);
+    // Checked before construction, so loading on a worker never ends the process
+    const InesHeader* header = (const InesHeader*)image->data();
+    uint8_t mapperId = (header->mapperHi << 4) | header->mapperLo;
+    if (!Mapper::isSupported(mapperId)) {
+        LOG_ERR << "Mapper " << int(mapperId) << " is not supported.\n";
+        return nullptr;
+    }
+
+    // The constructor is private, so not through make_shared
+    return std::shared_ptr<Cart>(new Cart(image, name, savePath));
 }
 
-Cart::Cart(uint8_t* data, std::string name) : m_data(data), m_name(name) {
+bool Cart::isValidImage(const RomImage& image) {
+    if (image.size() < sizeof(InesHeader)) {
+        return false;
+    }
+    const InesHeader* header = (const InesHeader*)image.data();
+    size_t size = sizeof(InesHeader)
+        + (header->hasTrainer ? TRAINER_BANK_SIZE : 0)
+        + PRG_BANK_SIZE * header->prgSize
+        + CHR_BANK_SIZE * header->chrSize;
+    return header->magic == INES_MAGIC && header->prgSize > 0 && image.size() >= size;
+}
+
+uint32_t Cart::romCrc(const RomImage& image) {
+    const InesHeader* header = (const InesHeader*)image.data();
+    const uint8_t* prg = image.data() + sizeof(InesHeader) + (header->hasTrainer ? TRAINER_BANK_SIZE : 0);
+    const uint8_t* chr = prg + PRG_BANK_SIZE * header->prgSize;
+    uint32_t crc = uint32_t(mz_crc32(MZ_CRC32_INIT, prg, PRG_BANK_SIZE * header->prgSize));
+    return uint32_t(mz_crc32(crc, chr, CHR_BANK_SIZE * header->chrSize));
+}
+
+Cart::Cart(std::shared_ptr<const RomImage> image, std::string name, const fs::path& savePath)
+    : m_name(name), m_image(image), m_header((const InesHeader*)image->data()) {
     // Now go through each entity in image and setup cart struct
-    uint8_t* cart_off = m_data;
-    cart_off += 0x10;  // After header
+    const uint8_t* cart_off = m_image->data();
+    cart_off += sizeof(InesHeader);
 
     // Cart has trainer?
     if (m_header->hasTrainer) {
-        m_trainer = (trainer_bank*)cart_off;
+        m_trainer = (const trainer_bank*)cart_off;
         cart_off += TRAINER_BANK_SIZE;
     }
 
     // PRG ROM, always available
-    m_prgBanks = (prg_bank*)cart_off;
+    m_prgBanks = (const prg_bank*)cart_off;
     cart_off += PRG_BANK_SIZE * this->prgSize();
 
-    // CHR ROM, available?
+    // CHR ROM, available? It is shared, only CHR RAM is ever written.
     if (m_header->chrSize != 0) {
         m_chrBanks = (chr_bank*)cart_off;
         m_chrSize = m_header->chrSize;
@@ -100,52 +208,102 @@ Cart::Cart(uint8_t* data, std::string name) : m_data(data), m_name(name) {
         // CHR RAM
         m_chrSize = 1;
         m_useChrRam = true;
-        m_chrBanks = new chr_bank[1];
+        m_chrRam = std::make_unique<chr_bank[]>(1);
+        m_chrBanks = m_chrRam.get();
+    }
+
+    // PRG RAM, kept in the save file if the cart has a battery. Writes go
+    // straight to the mapping, the OS writes them back to the file.
+    if (hasBattery() && !savePath.empty() && m_saveFile.openReadWrite(savePath, PRG_RAM_SIZE)) {
+        LOG_MSG << "Mapped battery RAM " << savePath << "\n";
+        m_prgRam = m_saveFile.data();
+    } else {
+        if (hasBattery() && !savePath.empty()) {
+            LOG_ERR << "Battery RAM could not be mapped from " << savePath << ", progress will not be saved\n";
+        }
+        m_prgRamBuffer = std::make_unique<uint8_t[]>(PRG_RAM_SIZE);
+        m_prgRam = m_prgRamBuffer.get();
     }
 
+    m_mirroring = m_header->mirroring ? Mirroring::Vertical : Mirroring::Horizontal;
+
+    m_crc = romCrc(*m_image);
+
     // Setup mapper id from flags fields from hi nybble of flags 6, 7
+    // fromImage made sure that Mapper::create has one for the id
     m_mapperId = (m_header->mapperHi << 4) | (m_header->mapperLo);
-    switch (m_mapperId) {
-    case 0: m_mapper = std::make_shared<Mapper000>(*this); break;
-    default:
-        LOG_ERR << "Mapper " << m_mapperId << " is not supported.\n";
-        exit(1);
-    }
+    m_mapper = Mapper::create(m_mapperId, *this);
 }
 
-Cart::~Cart()
-{
-    if (m_useChrRam) {
-        delete[] m_chrBanks;
-    }
-    delete m_data;
-}
+Cart::~Cart() {}
 
-const uint16_t nametableOffsets[2][4] = {
+const uint16_t nametableOffsets[4][4] = {
     { 0x0000, 0x0000, 0x0400, 0x0400 },  // Horizontal
     { 0x0000, 0x0400, 0x0000, 0x0400 },  // Vertical
+    { 0x0000, 0x0000, 0x0000, 0x0000 },  // Single Screen, lower bank
+    { 0x0400, 0x0400, 0x0400, 0x0400 },  // Single Screen, upper bank
 };
 
 uint16_t Cart::getNameTable(uint8_t index) {
-    return nametableOffsets[m_header->mirroring][index];
+    return nametableOffsets[uint8_t(m_mirroring)][index];
 }
 
-uint8_t Cart::readb_cpu(uint16_t address)
-{
-    return m_mapper->readbCpu(address);
+void Cart::setMirroring(Mirroring mirroring) {
+    if (m_mirroring != mirroring) {
+        m_mirroring = mirroring;
+        if (m_mirroringChanged) {
+            m_mirroringChanged();
+        }
+    }
+}
+
+void Cart::reset() {
+    m_irqLine = false;
+    m_mapper->reset();
+}
+
+void Cart::powerOn() {
+    if (m_chrRam) {
+        std::fill_n(*m_chrRam.get(), CHR_BANK_SIZE, 0);
+    }
+    if (m_prgRamBuffer) {
+        std::fill_n(m_prgRamBuffer.get(), PRG_RAM_SIZE, 0);
+    }
+
+    // A new mapper starts with the power on banks and mirroring
+    setMirroring(m_header->mirroring ? Mirroring::Vertical : Mirroring::Horizontal);
+    m_mapper = Mapper::create(m_mapperId, *this);
+    reset();
+}
+
+void Cart::unmapSave() {
+    if (m_saveFile.isOpen()) {
+        m_saveFile.close();
+        m_prgRamBuffer = std::make_unique<uint8_t[]>(PRG_RAM_SIZE);
+        m_prgRam = m_prgRamBuffer.get();
+        LOG_MSG << "Unmapped battery RAM\n";
+    }
+}
+
+bool Cart::hasScanlineCounter() const {
+    return m_mapper->hasScanlineCounter();
+}
+
+void Cart::clockScanlineCounter() {
+    m_mapper->clockScanlineCounter();
 }
 
 void Cart::translate_cpu(uint16_t addressIn, uint8_t& bankOut, uint16_t& addressOut) {
     return m_mapper->translateCpu(addressIn, bankOut, addressOut);
 }
 
-void Cart::writeb_cpu(uint16_t addr, uint8_t value) {
+void Cart::writeb_cpu(uint16_t addr, uint8_t value, unsigned long cycle) {
+    m_writeCycle = cycle;
     m_mapper->writebCpu(addr, value);
 }
 
-uint8_t Cart::readb_ppu(uint16_t addr)
-{
-    return m_mapper->readbPpu(addr);
+void Cart::translate_ppu(uint16_t addressIn, uint8_t& bankOut, uint16_t& addressOut) {
+    return m_mapper->translatePpu(addressIn, bankOut, addressOut);
 }
 
 void Cart::writeb_ppu(uint16_t addr, uint8_t value)
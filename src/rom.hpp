@@ -6,9 +6,14 @@
 #include <cstdlib>
 #include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <vector>
 
 #include "defs.hpp"
 #include "core/util.hpp"
+#include "core/mappedfile.hpp"
+#include "nes/mappers/bankedmapper.hpp"
 
 constexpr uint32_t HEADER_AS_UINT32(uint8_t* h) {
     return ((h[0]) | ((h[1]) << 8) | ((h[2]) << 16) | ((h[3]) << 24));
@@ -20,12 +25,41 @@ uint32_t constexpr INES_MAGIC = 0x1a53454e;
 size_t constexpr PRG_BANK_SIZE = 0x4000;
 size_t constexpr CHR_BANK_SIZE = 0x2000;
 size_t constexpr TRAINER_BANK_SIZE = 0x200;
+size_t constexpr PRG_RAM_SIZE = 0x2000;
 
 typedef uint8_t prg_bank[PRG_BANK_SIZE];
 typedef uint8_t chr_bank[CHR_BANK_SIZE];
 typedef uint8_t trainer_bank[TRAINER_BANK_SIZE];
 
-class Mapper;
+// Immutable contents of a ROM file. Plain files are mapped read-only, ZIP
+// archives are inflated once per contained ROM. Carts loaded from the same
+// contents share one image while any of them is alive.
+class RomImage {
+public:
+    static std::shared_ptr<const RomImage> fromNes(const std::filesystem::path& p);
+    static std::shared_ptr<const RomImage> fromZip(const std::filesystem::path& p, std::string& name);
+
+    RomImage(std::vector<uint8_t> data);
+
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    RomImage() = default;
+
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+
+    Util::MappedFile m_file;
+    std::vector<uint8_t> m_buffer;
+};
+
+enum class Mirroring : uint8_t {
+    Horizontal = 0,
+    Vertical = 1,
+    SingleScreenLow = 2,
+    SingleScreenHigh = 3,
+};
 
 class Cart {
     PACK(struct InesHeader {
@@ -34,20 +68,20 @@ class Cart {
         uint8_t              chrSize;
         union {
             struct {
-                unsigned int mirroring : 1;
-                unsigned int hasPrgRam : 1;
-                unsigned int hasTrainer : 1;
-                unsigned int hasVram : 1;
-                unsigned int mapperLo : 4;
+                uint8_t      mirroring : 1;
+                uint8_t      hasBattery : 1;
+                uint8_t      hasTrainer : 1;
+                uint8_t      hasVram : 1;
+                uint8_t      mapperLo : 4;
             };
             uint8_t          flags6;
         };
         union {
             struct {
-                unsigned int isVsUnisystem : 1;
-                unsigned int isPlaychoice10 : 1;
-                unsigned int isHeader20 : 2;
-                unsigned int mapperHi : 4;
+                uint8_t      isVsUnisystem : 1;
+                uint8_t      isPlaychoice10 : 1;
+                uint8_t      isHeader20 : 2;
+                uint8_t      mapperHi : 4;
             };
             uint8_t          flags7;
         };
@@ -56,48 +90,93 @@ class Cart {
         uint8_t              flags_10;
         uint8_t              zero[5];
     });
+    static_assert(sizeof(InesHeader) == 16, "iNES header must be packed");
 
 public:
-    static std::shared_ptr<Cart> fromFile(const std::filesystem::path& p);
+    static std::shared_ptr<Cart> fromFile(const std::filesystem::path& p, bool mapSave = true);  // Battery RAM in <rom>.sav
+    // nullptr if the image is not valid or its mapper is not supported. Battery
+    // backed PRG RAM is mapped from savePath, if given.
+    static std::shared_ptr<Cart> fromImage(std::shared_ptr<const RomImage> image, std::string name,
+                                           const std::filesystem::path& savePath = {});
+    static bool isValidImage(const RomImage& image);  // Header and size of an iNES file
+    static uint32_t romCrc(const RomImage& image);    // m_crc of a valid image
 
     const std::string m_name;
 
-    union {
-        uint8_t* m_data;
-        InesHeader* m_header;
-    };
+    std::shared_ptr<const RomImage> m_image;
+    const InesHeader* m_header;
 
     uint8_t m_mapperId;
+    uint32_t m_crc = 0;  // CRC32 over PRG and CHR ROM, identifies the game
     bool m_useChrRam = false;
 
-    trainer_bank* m_trainer = nullptr;
-    prg_bank* m_prgBanks;
-    chr_bank* m_chrBanks;
+    const trainer_bank* m_trainer = nullptr;
+    const prg_bank* m_prgBanks;
+    chr_bank* m_chrBanks;  // Points into the shared image unless m_useChrRam
     // play choice inst-rom
     // play choice p-rom
 
-    Cart(uint8_t*, std::string file = "<none>");
     ~Cart();
 
     inline uint8_t prgSize() const { return m_header->prgSize; }
     inline uint8_t chrSize() const { return m_chrSize; }
 
-    inline prg_bank& prg(uint8_t bank) const { return m_prgBanks[bank]; };
+    inline const prg_bank& prg(uint8_t bank) const { return m_prgBanks[bank]; };
     inline chr_bank& chr(uint8_t bank) const { return m_chrBanks[bank]; };
-
-    uint8_t readb_cpu(uint16_t address);
+    inline uint8_t* prgRam() const { return m_prgRam; }  // PRG_RAM_SIZE bytes at $6000
+    inline bool hasBattery() const { return m_header->hasBattery; }
+    inline bool isSaveMapped() const { return m_saveFile.isOpen(); }  // Battery RAM goes to the save file
+
+    // ROM reads are page table lookups, only the other accesses reach the concrete mapper
+    inline uint8_t readb_cpu(uint16_t address) {
+        return address >= 0x8000 ? m_mapper->readPrg(address) : m_mapper->readbCpu(address);
+    }
     void translate_cpu(uint16_t addressIn, uint8_t& bankOut, uint16_t& addressOut);
-    void writeb_cpu(uint16_t address, uint8_t value);
+    void writeb_cpu(uint16_t address, uint8_t value, unsigned long cycle);
+    unsigned long getWriteCycle() const { return m_writeCycle; }  // CPU cycle of the write the mapper is handling
+
+    inline uint8_t readb_ppu(uint16_t address) { return m_mapper->readChr(address); }
+    void translate_ppu(uint16_t addressIn, uint8_t& bankOut, uint16_t& addressOut);
 
-    uint8_t readb_ppu(uint16_t address);
+    // Byte offsets into PRG and CHR ROM, page table lookups for the Code/Data Logger
+    inline size_t prgOffset(uint16_t address) const { return m_mapper->prgOffset(address); }
+    inline size_t chrOffset(uint16_t address) const { return m_mapper->chrOffset(address); }
     void writeb_ppu(uint16_t address, uint8_t value);
 
     uint16_t getNameTable(uint8_t index);
+    Mirroring getMirroring() const { return m_mirroring; }
+    void setMirroring(Mirroring mirroring);  // Used by mappers with mirroring control
+    void setMirroringFn(std::function<void()> fn) { m_mirroringChanged = fn; }
+
+    void reset();
+    void powerOn();  // Also clears mapper registers and RAM that is not battery backed
+    void unmapSave();  // Battery RAM is cleared memory from now on, the save file keeps what it had
+
+    // Cart IRQ line, level triggered. Held by the mapper until acknowledged.
+    bool irqAsserted() const { return m_irqLine; }
+    void setIrq(bool asserted) { m_irqLine = asserted; }
+
+    bool hasScanlineCounter() const;
+    void clockScanlineCounter();  // Rising edge of PPU A12
 
 private:
+    // Only through fromImage, which rejects what the constructor can't handle
+    Cart(std::shared_ptr<const RomImage> image, std::string file, const std::filesystem::path& savePath);
+
     uint8_t m_chrSize = 0;
+    std::unique_ptr<chr_bank[]> m_chrRam;
+
+    uint8_t* m_prgRam = nullptr;
+    std::unique_ptr<uint8_t[]> m_prgRamBuffer;  // Without battery or if the save file can't be mapped
+    Util::MappedFile m_saveFile;
+
+    Mirroring m_mirroring;
+    std::function<void()> m_mirroringChanged;
+
+    bool m_irqLine = false;
+    unsigned long m_writeCycle = 0;
 
-    std::shared_ptr<Mapper> m_mapper;
+    std::shared_ptr<BankedMapper> m_mapper;
 };
 
 #endif
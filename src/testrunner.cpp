@@ -0,0 +1,256 @@
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "testrunner.hpp"
+#include "emu.hpp"
+#include "mem.hpp"
+#include "rom.hpp"
+#include "core/util.hpp"
+
+namespace fs = std::filesystem;
+
+namespace TestRunner {
+    // Frames to wait before pressing reset, a little more than the 100ms asked for
+    static unsigned int constexpr RESET_DELAY = 8;
+
+    static const char* statusNames[] = { "PASS", "FAIL", "XFAIL", "MISMATCH", "NO GOLDEN", "TIMEOUT", "ERROR" };
+
+    static bool hasSignature(Emu& emu) {
+        return emu.m_mem->peekb(SIGNATURE_ADDRESS) == 0xde
+            && emu.m_mem->peekb(SIGNATURE_ADDRESS + 1) == 0xb0
+            && emu.m_mem->peekb(SIGNATURE_ADDRESS + 2) == 0x61;
+    }
+
+    static std::string readMessage(Emu& emu) {
+        std::string message;
+        for (uint16_t address = MESSAGE_ADDRESS; address < 0x8000; address++) {
+            char c = char(emu.m_mem->peekb(address));
+            if (c == 0) {
+                break;
+            }
+            message += c;
+        }
+
+        // Only the first line fits into the matrix
+        message.erase(std::find(message.begin(), message.end(), '\n'), message.end());
+        return message;
+    }
+}
+
+TestRunner::Result TestRunner::run(const fs::path& dir, const fs::path& rom, unsigned int maxFrames) {
+    Result result;
+    result.rom = rom;
+
+    // Battery RAM would carry state from one run into the next
+    std::shared_ptr<Cart> cart = Cart::fromFile(dir / rom, false);
+    if (!cart) {
+        result.message = "Could not be loaded";
+        return result;
+    }
+
+    Emu emu(Emu::Config{});
+    emu.init(cart);
+    emu.m_isStepping = false;
+
+    bool running = false;
+    unsigned int resetFrame = 0;
+    while (result.frames < maxFrames) {
+        emu.stepFrame();
+        result.frames++;
+
+        if (emu.m_isStepping) {
+            result.message = "CPU error";
+            result.hash = emu.hashState();
+            return result;
+        }
+
+        if (!hasSignature(emu)) {
+            continue;
+        }
+
+        uint8_t status = emu.m_mem->peekb(STATUS_ADDRESS);
+        if (status == STATUS_RESET) {
+            if (resetFrame == 0) {
+                resetFrame = result.frames + RESET_DELAY;
+            } else if (result.frames >= resetFrame) {
+                emu.reset();
+                resetFrame = 0;
+            }
+        } else if (status < STATUS_RUNNING) {
+            result.code = status;
+            break;
+        }
+        running = true;
+    }
+
+    if (result.code == 0) {
+        result.status = Status::Passed;
+    } else if (result.code > 0) {
+        result.status = Status::Failed;
+    } else {
+        result.status = running ? Status::Timeout : Status::NoGolden;
+    }
+    result.message = readMessage(emu);
+    result.hash = emu.hashState();
+    return result;
+}
+
+std::vector<TestRunner::Result> TestRunner::runAll(const fs::path& dir, unsigned int maxFrames, unsigned int jobs) {
+    std::vector<fs::path> roms;
+    for (const fs::directory_entry& entry : fs::recursive_directory_iterator(dir)) {
+        fs::path extension = entry.path().extension();
+        if (entry.is_regular_file() && (extension == ".nes" || extension == ".zip")) {
+            roms.push_back(fs::relative(entry.path(), dir));
+        }
+    }
+    std::sort(roms.begin(), roms.end());
+
+    // Each worker takes the next ROM until none are left
+    std::vector<Result> results(roms.size());
+    std::atomic<size_t> next{ 0 };
+    auto worker = [&]() {
+        for (size_t i = next++; i < roms.size(); i = next++) {
+            results[i] = run(dir, roms[i], maxFrames);
+        }
+    };
+
+    if (jobs == 0) {
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < std::min<size_t>(jobs, roms.size()); i++) {
+        threads.emplace_back(worker);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return results;
+}
+
+bool TestRunner::loadGoldens(const fs::path& path, Goldens& goldens) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        LOG_ERR << "Goldens " << path << " could not be opened.\n";
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        Golden golden;
+        std::string rom;
+        if (fields >> std::hex >> golden.hash >> std::dec >> golden.code >> std::ws && std::getline(fields, rom)) {
+            goldens[rom] = golden;
+        }
+    }
+    return true;
+}
+
+bool TestRunner::saveGoldens(const fs::path& path, const std::vector<Result>& results) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        LOG_ERR << "Goldens " << path << " could not be opened.\n";
+        return false;
+    }
+
+    for (const Result& result : results) {
+        // Every run that completed is kept, failures included
+        if (result.status != Status::Timeout && result.status != Status::Error) {
+            out << std::hex << std::setfill('0') << std::setw(8) << result.hash << " "
+                << std::dec << result.code << " " << result.rom.generic_string() << "\n";
+        }
+    }
+    return true;
+}
+
+void TestRunner::compare(std::vector<Result>& results, const Goldens& goldens) {
+    for (Result& result : results) {
+        if (result.status != Status::Passed && result.status != Status::Failed && result.status != Status::NoGolden) {
+            continue;
+        }
+
+        auto golden = goldens.find(result.rom.generic_string());
+        if (golden == goldens.end()) {
+            continue;
+        }
+        if (golden->second.hash == result.hash && golden->second.code == result.code) {
+            result.status = result.status == Status::Failed ? Status::KnownFailure : Status::Passed;
+        } else if (result.status != Status::Failed) {
+            // New failures keep their status, they say more than a hash
+            result.status = Status::Mismatch;
+        }
+    }
+}
+
+void TestRunner::printMatrix(std::ostream& out, const std::vector<Result>& results) {
+    size_t width = 3;
+    for (const Result& result : results) {
+        width = std::max(width, result.rom.generic_string().size());
+    }
+
+    out << std::left << std::setw(width) << "ROM" << "  Result     Code  Frames  Hash      Message\n";
+
+    size_t passed = 0;
+    size_t knownFailures = 0;
+    for (const Result& result : results) {
+        out << std::left << std::setfill(' ') << std::setw(width) << result.rom.generic_string() << "  "
+            << std::setw(9) << statusNames[int(result.status)] << "  "
+            << std::right << std::setw(4);
+        if (result.code >= 0) {
+            out << result.code;
+        } else {
+            out << "-";
+        }
+        out << "  " << std::setw(6) << result.frames << "  "
+            << std::hex << std::setfill('0') << std::setw(8) << result.hash << std::dec << std::setfill(' ') << "  "
+            << result.message << "\n";
+
+        passed += result.status == Status::Passed;
+        knownFailures += result.status == Status::KnownFailure;
+    }
+
+    out << passed << " of " << results.size() << " passed, " << knownFailures << " known failures\n";
+}
+
+int TestRunner::runSuite(const fs::path& dir, const fs::path& goldensPath, bool updateGoldens,
+                         unsigned int maxFrames, unsigned int jobs) {
+    if (!fs::is_directory(dir)) {
+        LOG_ERR << "Test directory " << dir << " does not exist.\n";
+        return EXIT_FAILURE;
+    }
+
+    Goldens goldens;
+    if (fs::exists(goldensPath) && !loadGoldens(goldensPath, goldens)) {
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Result> results = runAll(dir, maxFrames, jobs);
+    compare(results, goldens);
+    printMatrix(std::cout, results);
+
+    if (updateGoldens) {
+        if (!saveGoldens(goldensPath, results)) {
+            return EXIT_FAILURE;
+        }
+
+        // The new goldens are taken as they are, only runs that did not complete fail
+        bool completed = std::none_of(results.begin(), results.end(), [](const Result& result) {
+            return result.status == Status::Timeout || result.status == Status::Error;
+        });
+        return completed ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    bool passed = std::all_of(results.begin(), results.end(), [](const Result& result) {
+        return result.status == Status::Passed || result.status == Status::KnownFailure;
+    });
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <filesystem>
+
+// Runs a directory of test ROMs without a window, several at a time. ROMs
+// that report through $6000 like blargg's test suites are run until they
+// report a result, all others for a fixed number of frames. The state hash
+// and result code after the last frame are compared with the golden ones
+// checked in for the ROM, see https://github.com/christopherpow/nes-test-roms.
+// Goldens of failing ROMs are kept too, failing the same way again is no regression.
+namespace TestRunner {
+    // Result protocol of blargg's test ROMs
+    uint16_t constexpr STATUS_ADDRESS = 0x6000;     // Result code once it is below STATUS_RUNNING
+    uint16_t constexpr SIGNATURE_ADDRESS = 0x6001;  // $de $b0 $61 once $6000 is valid
+    uint16_t constexpr MESSAGE_ADDRESS = 0x6004;    // Zero terminated text output
+    uint8_t constexpr STATUS_RUNNING = 0x80;
+    uint8_t constexpr STATUS_RESET = 0x81;          // Wants the reset button pressed after 100ms
+
+    enum class Status {
+        Passed,
+        Failed,
+        KnownFailure,  // Failed with the golden hash and code
+        Mismatch,   // Ran, but the hash differs from the golden one
+        NoGolden,   // Ran without reporting a result and there is nothing to compare with
+        Timeout,    // Reported it was running, but never finished
+        Error,      // Could not be loaded or crashed the CPU
+    };
+
+    struct Result {
+        std::filesystem::path rom;  // Relative to the test directory
+        Status status = Status::Error;
+        int code = -1;              // Reported result, -1 if the ROM does not report through $6000
+        std::string message;
+        unsigned int frames = 0;
+        uint32_t hash = 0;          // Emu::hashState after the last frame
+    };
+
+    struct Golden {
+        uint32_t hash = 0;
+        int code = -1;
+    };
+    using Goldens = std::map<std::string, Golden>;
+
+    Result run(const std::filesystem::path& dir, const std::filesystem::path& rom, unsigned int maxFrames);
+
+    // Runs every .nes and .zip below dir on jobs worker threads, in path order
+    std::vector<Result> runAll(const std::filesystem::path& dir, unsigned int maxFrames, unsigned int jobs);
+
+    // Lines of "<crc32> <code> <relative path>", lines starting with # are comments
+    bool loadGoldens(const std::filesystem::path& path, Goldens& goldens);
+    bool saveGoldens(const std::filesystem::path& path, const std::vector<Result>& results);
+
+    void compare(std::vector<Result>& results, const Goldens& goldens);
+    void printMatrix(std::ostream& out, const std::vector<Result>& results);
+
+    // Runs the suite and prints the results, returns the process exit code
+    int runSuite(const std::filesystem::path& dir, const std::filesystem::path& goldensPath, bool updateGoldens,
+                 unsigned int maxFrames, unsigned int jobs);
+}